@@ -0,0 +1,426 @@
+// Renders a fixed set of scenes along fixed camera paths and reports their timings and pipeline statistics as JSON
+// Every run renders exactly the same frames, so results can be compared between commits
+//
+// RenderSoftBench [--frames N] [--warmup N] [--width W] [--height H] [--threads N] [--scene name] [--output file.json]
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <GCore/Graphics/Color.hpp>
+#include <GCore/Graphics/MeshData.hpp>
+#include <GCore/Math/Math.hpp>
+
+#include "CommandList.hpp"
+#include "DrawCall.hpp"
+#include "FrameBuffer.hpp"
+#include "MeshAssets.hpp"
+#include "MeshCache.hpp"
+#include "PipelineStatistics.hpp"
+#include "RasterKernels.hpp"
+#include "Renderer.hpp"
+#include "Texture.hpp"
+#include "Viewport.hpp"
+
+using namespace RS;
+
+static constexpr double FrameTime = 1.0 / 60.0;
+
+struct BenchOptions
+{
+	uint32_t numFrames = 200;
+	uint32_t numWarmupFrames = 10;
+	uint16_t width = 1280;
+	uint16_t height = 720;
+	uint32_t numThreads = std::thread::hardware_concurrency();
+	std::string sceneFilter;
+	std::string outputPath;
+};
+
+// One draw of a scene. Instance transforms place it in the world, the camera path supplies the view
+struct BenchLayer
+{
+	MeshView mesh;
+	std::vector<Gadget::Matrix4> instanceTransforms;
+	std::vector<Gadget::Color> instanceColors;
+	CullMode cullMode = CullMode::CCW;
+	DepthTestMode depthMode = DepthTestMode::Less;
+	bool writeDepth = true;
+	bool isScreenSpace = false; // Instance transforms already give clip space positions
+	const Texture* texture = nullptr;
+};
+
+struct BenchScene
+{
+	std::string name;
+	std::vector<BenchLayer> layers;
+	Gadget::Matrix4(*cameraPath)(double time) = nullptr; // View matrix at the given time
+};
+
+struct BenchResult
+{
+	std::string name;
+	uint64_t trianglesPerFrame = 0;
+	std::vector<double> frameTimes; // Milliseconds
+	PipelineStatistics statistics;	// Summed over every timed frame
+};
+
+static std::optional<std::string_view> GetArgument(std::span<char*> args, std::string_view name)
+{
+	for (size_t i = 1; i + 1 < args.size(); i++)
+	{
+		if (std::string_view(args[i]) == name)
+		{
+			return std::string_view(args[i + 1]);
+		}
+	}
+
+	return std::nullopt;
+}
+
+template <typename T>
+static void ParseNumber(std::span<char*> args, std::string_view name, T& outValue)
+{
+	const auto text = GetArgument(args, name);
+	if (!text.has_value())
+	{
+		return;
+	}
+
+	T value{};
+	const auto result = std::from_chars(text->data(), text->data() + text->size(), value);
+	if (result.ec != std::errc() || result.ptr != text->data() + text->size())
+	{
+		std::println(stderr, "Invalid value '{}' for {}", *text, name);
+		return;
+	}
+
+	outValue = value;
+}
+
+static BenchOptions ParseOptions(std::span<char*> args)
+{
+	BenchOptions options;
+	ParseNumber(args, "--frames", options.numFrames);
+	ParseNumber(args, "--warmup", options.numWarmupFrames);
+	ParseNumber(args, "--width", options.width);
+	ParseNumber(args, "--height", options.height);
+	ParseNumber(args, "--threads", options.numThreads);
+	options.sceneFilter = std::string(GetArgument(args, "--scene").value_or(""));
+	options.outputPath = std::string(GetArgument(args, "--output").value_or(""));
+	return options;
+}
+
+static Gadget::Matrix4 ModelMatrix(const Gadget::Vector3& pos, const Gadget::Euler& rot, const Gadget::Vector3& scale)
+{
+	return Gadget::Math::Translate(pos) * (Gadget::Math::ToMatrix4(Gadget::Math::ToQuaternion(rot)) * Gadget::Math::Scale(scale));
+}
+
+// Circles the origin at a fixed distance
+static Gadget::Matrix4 OrbitCamera(double time)
+{
+	return ModelMatrix(Gadget::Vector3(0.0, 0.0, -6.0), Gadget::Euler(20.0, time * 45.0, 0.0), Gadget::Vector3(1.0, 1.0, 1.0));
+}
+
+// Slowly pans over a large grid from above
+static Gadget::Matrix4 PanCamera(double time)
+{
+	return ModelMatrix(Gadget::Vector3(-std::sin(time * 0.5) * 10.0, 0.0, -40.0), Gadget::Euler(35.0, time * 10.0, 0.0), Gadget::Vector3(1.0, 1.0, 1.0));
+}
+
+// Flies between the cubes at their height, so the ones closest to the camera cross the near plane
+static Gadget::Matrix4 FlyThroughCamera(double time)
+{
+	const auto rotation = Gadget::Math::ToMatrix4(Gadget::Math::ToQuaternion(Gadget::Euler(0.0, std::sin(time) * 30.0, 0.0)));
+	return rotation * Gadget::Math::Translate(Gadget::Vector3(0.3, 0.0, 20.0 - std::fmod(time * 8.0, 40.0)));
+}
+
+// Far enough away that every cube covers a pixel or two
+static Gadget::Matrix4 DistantCamera(double time)
+{
+	return ModelMatrix(Gadget::Vector3(0.0, 0.0, -300.0), Gadget::Euler(10.0, time * 5.0, 0.0), Gadget::Vector3(1.0, 1.0, 1.0));
+}
+
+static Gadget::Matrix4 FixedCamera(double)
+{
+	return Gadget::Matrix4::Identity();
+}
+
+// Square grid of instances on the XZ plane, centered on the origin
+static BenchLayer MakeGrid(MeshView mesh, int32_t size, double spacing, double scale)
+{
+	BenchLayer layer;
+	layer.mesh = mesh;
+	layer.instanceTransforms.reserve(static_cast<size_t>(size) * size);
+	layer.instanceColors.reserve(static_cast<size_t>(size) * size);
+
+	const double offset = (size - 1) * spacing * 0.5;
+	for (int32_t z = 0; z < size; z++)
+	{
+		for (int32_t x = 0; x < size; x++)
+		{
+			const auto pos = Gadget::Vector3((x * spacing) - offset, 0.0, (z * spacing) - offset);
+			layer.instanceTransforms.push_back(ModelMatrix(pos, Gadget::Euler(x * 7.0, z * 11.0, 0.0), Gadget::Vector3(scale, scale, scale)));
+			layer.instanceColors.emplace_back(0.5 + (0.5 * x / size), 0.5 + (0.5 * z / size), 1.0, 1.0);
+		}
+	}
+
+	return layer;
+}
+
+// Two-tone checkerboard with a gradient on top, so every mip level looks different
+static Texture MakeCheckerTexture(uint16_t size, uint16_t checkSize)
+{
+	std::vector<PixelRGBA8> texels;
+	texels.reserve(static_cast<size_t>(size) * size);
+	for (uint16_t y = 0; y < size; y++)
+	{
+		for (uint16_t x = 0; x < size; x++)
+		{
+			const bool isDark = ((x / checkSize) + (y / checkSize)) % 2 == 0;
+			const auto shade = static_cast<uint8_t>(isDark ? 48 : 255);
+			texels.push_back(PixelRGBA8{ shade, static_cast<uint8_t>(shade * x / size), static_cast<uint8_t>(shade * y / size), 255 });
+		}
+	}
+
+	return Texture(size, size, texels);
+}
+
+static std::vector<BenchScene> MakeScenes(const CachedModel& teapot, const Gadget::MeshData& cube, const Gadget::MeshData& rect, MeshView texturedRect, const Texture& checker)
+{
+	std::vector<BenchScene> scenes;
+
+	if (!teapot.IsEmpty())
+	{
+		BenchLayer layer;
+		layer.mesh = teapot.Meshes()[0];
+		layer.instanceTransforms.push_back(ModelMatrix(Gadget::Vector3(0.0, 0.0, 0.0), Gadget::Euler(-90.0, 0.0, 0.0), Gadget::Vector3(0.5, 0.5, 0.5)));
+		scenes.push_back(BenchScene{ "teapot", { std::move(layer) }, OrbitCamera });
+	}
+
+	scenes.push_back(BenchScene{ "cube_grid", { MakeGrid(cube, 32, 3.0, 1.0) }, PanCamera });
+
+	// Overlapping quads that each cover the whole screen, without any depth test to cut the work short
+	BenchLayer fillLayer;
+	fillLayer.mesh = rect;
+	fillLayer.cullMode = CullMode::None;
+	fillLayer.depthMode = DepthTestMode::Always;
+	fillLayer.writeDepth = false;
+	fillLayer.isScreenSpace = true;
+	for (int32_t i = 0; i < 8; i++)
+	{
+		fillLayer.instanceTransforms.push_back(Gadget::Math::Translate(Gadget::Vector3(0.0, 0.0, 0.1 * i)));
+		fillLayer.instanceColors.emplace_back(1.0, 1.0 - (0.1 * i), 0.5 + (0.05 * i), 1.0);
+	}
+	scenes.push_back(BenchScene{ "fill_rate", { std::move(fillLayer) }, FixedCamera });
+
+	// Ground plane that always crosses the near plane, plus cubes the camera passes right next to
+	BenchLayer groundLayer;
+	groundLayer.mesh = rect;
+	groundLayer.cullMode = CullMode::None;
+	groundLayer.instanceTransforms.push_back(ModelMatrix(Gadget::Vector3(0.0, -1.5, 0.0), Gadget::Euler(90.0, 0.0, 0.0), Gadget::Vector3(500.0, 500.0, 1.0)));
+	scenes.push_back(BenchScene{ "near_clip", { std::move(groundLayer), MakeGrid(cube, 16, 2.5, 1.0) }, FlyThroughCamera });
+
+	scenes.push_back(BenchScene{ "tiny_triangles", { MakeGrid(cube, 128, 2.0, 0.4) }, DistantCamera });
+
+	// Same flight over the ground plane, but textured, so it mostly measures sampling from magnified to heavily minified
+	BenchLayer texturedGroundLayer;
+	texturedGroundLayer.mesh = texturedRect;
+	texturedGroundLayer.cullMode = CullMode::None;
+	texturedGroundLayer.texture = &checker;
+	texturedGroundLayer.instanceTransforms.push_back(ModelMatrix(Gadget::Vector3(0.0, -1.5, 0.0), Gadget::Euler(90.0, 0.0, 0.0), Gadget::Vector3(500.0, 500.0, 1.0)));
+	scenes.push_back(BenchScene{ "textured_ground", { std::move(texturedGroundLayer) }, FlyThroughCamera });
+
+	return scenes;
+}
+
+static void RenderFrame(const BenchScene& scene, uint32_t frame, const Gadget::Matrix4& projection, const Viewport& viewport, Renderer& renderer, FrameBuffer& frameBuffer, CommandList& commands)
+{
+	const auto viewProjection = projection * scene.cameraPath(frame * FrameTime);
+
+	commands.Clear();
+	for (const auto& layer : scene.layers)
+	{
+		auto drawCall = DrawCall(layer.mesh, layer.instanceTransforms, layer.instanceColors, layer.isScreenSpace ? Gadget::Matrix4::Identity() : viewProjection);
+		drawCall.mode = layer.cullMode;
+		drawCall.depthMode = layer.depthMode;
+		drawCall.writeDepth = layer.writeDepth;
+		drawCall.texture = layer.texture;
+		commands.Add(drawCall);
+	}
+
+	frameBuffer.Clear();
+	renderer.Submit(viewport, frameBuffer, commands);
+	frameBuffer.ResolveColor();
+}
+
+static BenchResult RunScene(const BenchScene& scene, const BenchOptions& options, Renderer& renderer, FrameBuffer& frameBuffer)
+{
+	const auto viewport = Viewport(0, options.width, 0, options.height);
+	const auto projection = Gadget::Matrix4::Perspective(90.0, options.width * 1.0 / options.height, 0.01, 1000.0);
+
+	BenchResult result;
+	result.name = scene.name;
+	for (const auto& layer : scene.layers)
+	{
+		result.trianglesPerFrame += layer.mesh.NumTriangles() * layer.instanceTransforms.size();
+	}
+	result.frameTimes.reserve(options.numFrames);
+
+	CommandList commands;
+	for (uint32_t frame = 0; frame < options.numWarmupFrames + options.numFrames; frame++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		RenderFrame(scene, frame, projection, viewport, renderer, frameBuffer, commands);
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (frame >= options.numWarmupFrames)
+		{
+			result.frameTimes.push_back(elapsed);
+		}
+	}
+
+	// Counting costs a little, so statistics come from a second, untimed pass over the same frames
+	renderer.ResetStatistics();
+	renderer.EnableStatistics(true);
+	for (uint32_t frame = options.numWarmupFrames; frame < options.numWarmupFrames + options.numFrames; frame++)
+	{
+		RenderFrame(scene, frame, projection, viewport, renderer, frameBuffer, commands);
+	}
+	renderer.EnableStatistics(false);
+	result.statistics = renderer.GetStatistics();
+
+	return result;
+}
+
+// Nearest-rank percentile of sorted values
+static double Percentile(const std::vector<double>& sorted, double percent)
+{
+	const auto rank = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(sorted.size())));
+	return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+static void WriteJson(FILE* file, const std::vector<BenchResult>& results, const BenchOptions& options, uint32_t numThreads)
+{
+	const uint64_t pixelsPerFrame = static_cast<uint64_t>(options.width) * options.height;
+
+	std::println(file, "{{");
+	std::println(file, "\t\"width\": {},", options.width);
+	std::println(file, "\t\"height\": {},", options.height);
+	std::println(file, "\t\"threads\": {},", numThreads);
+	std::println(file, "\t\"kernels\": \"{}\",", Raster::GetSelectedKernelName());
+	std::println(file, "\t\"frames\": {},", options.numFrames);
+	std::println(file, "\t\"warmupFrames\": {},", options.numWarmupFrames);
+	std::println(file, "\t\"scenes\": [");
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		auto sorted = results[i].frameTimes;
+		std::ranges::sort(sorted);
+
+		double total = 0.0;
+		for (const double time : sorted)
+		{
+			total += time;
+		}
+		const double seconds = total / 1'000.0;
+
+		std::println(file, "\t\t{{");
+		std::println(file, "\t\t\t\"name\": \"{}\",", results[i].name);
+		std::println(file, "\t\t\t\"trianglesPerFrame\": {},", results[i].trianglesPerFrame);
+		std::println(file, "\t\t\t\"trianglesPerSec\": {:.0f},", static_cast<double>(results[i].trianglesPerFrame * sorted.size()) / seconds);
+		std::println(file, "\t\t\t\"pixelsPerSec\": {:.0f},", static_cast<double>(pixelsPerFrame * sorted.size()) / seconds);
+		std::println(file, "\t\t\t\"shadedPixelsPerSec\": {:.0f},", static_cast<double>(results[i].statistics.colorWrites) / seconds);
+		std::println(file, "\t\t\t\"meanMs\": {:.4f},", total / static_cast<double>(sorted.size()));
+		std::println(file, "\t\t\t\"minMs\": {:.4f},", sorted.front());
+		std::println(file, "\t\t\t\"p50Ms\": {:.4f},", Percentile(sorted, 50.0));
+		std::println(file, "\t\t\t\"p99Ms\": {:.4f},", Percentile(sorted, 99.0));
+		std::println(file, "\t\t\t\"maxMs\": {:.4f},", sorted.back());
+
+		// Per frame averages
+		std::println(file, "\t\t\t\"statistics\": {{");
+		bool isFirst = true;
+		results[i].statistics.ForEachCounter([&](const char* name, uint64_t value)
+		{
+			std::print(file, "{}\t\t\t\t\"{}\": {:.1f}", isFirst ? "" : ",\n", name, static_cast<double>(value) / static_cast<double>(sorted.size()));
+			isFirst = false;
+		});
+		std::println(file, "\n\t\t\t}}");
+		std::println(file, "{}", (i + 1 < results.size()) ? "\t\t}," : "\t\t}");
+	}
+
+	std::println(file, "\t]");
+	std::println(file, "}}");
+}
+
+int main(int argc, char* argv[])
+{
+	const auto options = ParseOptions(std::span(argv, static_cast<size_t>(argc)));
+	if (options.numFrames == 0 || options.width == 0 || options.height == 0)
+	{
+		std::println(stderr, "Frame count and resolution have to be greater than zero");
+		return 1;
+	}
+
+	const auto teapotModel = LoadCachedModel("assets/teapot.stl");
+	if (teapotModel.IsEmpty())
+	{
+		std::println(stderr, "Could not load the teapot model, skipping the teapot scene");
+	}
+
+	const auto cube = GetCubeMesh();
+	const auto rect = GetRectMesh();
+
+	// Repeats the texture every 10 units across the ground plane
+	const std::vector<TexCoord> rectTexCoords = { TexCoord{ 0.0f, 0.0f }, TexCoord{ 100.0f, 0.0f }, TexCoord{ 0.0f, 100.0f }, TexCoord{ 100.0f, 100.0f } };
+	const auto checker = MakeCheckerTexture(256, 32);
+	const auto scenes = MakeScenes(teapotModel, cube, rect, MeshView(rect.vertices, rect.indices, {}, rectTexCoords), checker);
+
+	Renderer renderer(options.numThreads);
+	FrameBuffer frameBuffer(options.width, options.height);
+
+	std::vector<BenchResult> results;
+	for (const auto& scene : scenes)
+	{
+		if (!options.sceneFilter.empty() && scene.name != options.sceneFilter)
+		{
+			continue;
+		}
+
+		std::println(stderr, "Running {}...", scene.name);
+		results.push_back(RunScene(scene, options, renderer, frameBuffer));
+	}
+
+	if (results.empty())
+	{
+		std::println(stderr, "No scene named '{}'", options.sceneFilter);
+		return 1;
+	}
+
+	if (options.outputPath.empty())
+	{
+		WriteJson(stdout, results, options, renderer.GetJobSystem().NumThreads());
+		return 0;
+	}
+
+	FILE* file = std::fopen(options.outputPath.c_str(), "wb");
+	if (file == nullptr)
+	{
+		std::println(stderr, "Could not open {} for writing", options.outputPath);
+		return 1;
+	}
+
+	WriteJson(file, results, options, renderer.GetJobSystem().NumThreads());
+	std::fclose(file);
+	std::println(stderr, "Wrote results to {}", options.outputPath);
+	return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GCore/Math/Vector.hpp>
+
+namespace RS
+{
+	// Precision of the vertex, clip and raster math. Meshes and transforms stay in double,
+	// positions are narrowed once as they leave the vertex stage
+	// Float halves the size of the clip vertex buffer and doubles how many depth values fit in a SIMD register
+#if defined(RS_PIPELINE_PRECISION_FLOAT)
+	using Real = float;
+#else
+	using Real = double;
+#endif
+
+	// Homogeneous clip-space position in the pipeline's precision
+	struct ClipPosition
+	{
+		Real x = 0;
+		Real y = 0;
+		Real z = 0;
+		Real w = 0;
+
+		constexpr ClipPosition() = default;
+		constexpr ClipPosition(Real x_, Real y_, Real z_, Real w_) : x(x_), y(y_), z(z_), w(w_){}
+		explicit constexpr ClipPosition(const Gadget::Vector4& position) : x(static_cast<Real>(position.x)), y(static_cast<Real>(position.y)), z(static_cast<Real>(position.z)), w(static_cast<Real>(position.w)){}
+
+		// Perspective divide, only meaningful for w > 0
+		constexpr ClipPosition Project() const{ return ClipPosition(x / w, y / w, z / w, w / w); }
+
+		static constexpr Real Dot(const ClipPosition& a, const ClipPosition& b){ return (a.x * b.x) + (a.y * b.y) + (a.z * b.z) + (a.w * b.w); }
+
+		static constexpr ClipPosition Lerp(const ClipPosition& a, const ClipPosition& b, Real t)
+		{
+			const Real s = 1 - t;
+			return ClipPosition((s * a.x) + (t * b.x), (s * a.y) + (t * b.y), (s * a.z) + (t * b.z), (s * a.w) + (t * b.w));
+		}
+	};
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <GCore/Graphics/Color.hpp>
+
+#include "ClipPosition.hpp"
+#include "Raster.hpp"
+
+namespace RS
+{
+	// Output of the vertex stage - every mesh vertex transformed to clip space exactly once
+	// Stored as a structure of arrays so later stages can work on many vertices at a time
+	struct ClipVertexBuffer
+	{
+		std::vector<Real> x;
+		std::vector<Real> y;
+		std::vector<Real> z;
+		std::vector<Real> w;
+
+		std::vector<float> r;
+		std::vector<float> g;
+		std::vector<float> b;
+		std::vector<float> a;
+
+		// Only filled in for meshes that have texture coordinates
+		std::vector<float> u;
+		std::vector<float> v;
+
+		std::vector<uint16_t> outcodes; // Raster::Outcode bits
+
+		// Viewport position snapped to 28.4 fixed point. Only valid for vertices in front of the camera and inside the guard band
+		std::vector<int64_t> snappedX;
+		std::vector<int64_t> snappedY;
+
+		// Keeps the allocations around between draws
+		void Resize(size_t count)
+		{
+			x.resize(count);
+			y.resize(count);
+			z.resize(count);
+			w.resize(count);
+			r.resize(count);
+			g.resize(count);
+			b.resize(count);
+			a.resize(count);
+			u.resize(count);
+			v.resize(count);
+			outcodes.resize(count);
+			snappedX.resize(count);
+			snappedY.resize(count);
+		}
+
+		size_t Size() const{ return x.size(); }
+
+		void Set(size_t i, const ClipPosition& position, const Gadget::Color& color, uint16_t outcode)
+		{
+			x[i] = position.x;
+			y[i] = position.y;
+			z[i] = position.z;
+			w[i] = position.w;
+			r[i] = color.r;
+			g[i] = color.g;
+			b[i] = color.b;
+			a[i] = color.a;
+			outcodes[i] = outcode;
+		}
+
+		void SetTexCoord(size_t i, const TexCoord& texCoord)
+		{
+			u[i] = texCoord.u;
+			v[i] = texCoord.v;
+		}
+
+		ClipPosition GetPosition(size_t i) const{ return ClipPosition(x[i], y[i], z[i], w[i]); }
+		Gadget::Color GetColor(size_t i) const{ return Gadget::Color(r[i], g[i], b[i], a[i]); }
+		TexCoord GetTexCoord(size_t i) const{ return TexCoord{ u[i], v[i] }; }
+		Raster::ClipVertex GetVertex(size_t i) const{ return Raster::ClipVertex{ GetPosition(i), GetColor(i), GetTexCoord(i) }; }
+	};
+}
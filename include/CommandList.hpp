@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DrawCall.hpp"
+
+namespace RS
+{
+	// Records every draw of a frame so the renderer can process all of them in one parallel pass
+	class CommandList
+	{
+	public:
+		void Add(const DrawCall& drawCall){ drawCalls.push_back(drawCall); }
+		void Clear(){ drawCalls.clear(); }
+
+		// Lets BuildExecutionOrder sort draws front-to-back. Off by default, because where two of those draws
+		// produce exactly the same depth, the one drawn first wins instead of the one submitted first
+		void EnableDepthReordering(bool enable){ reorderForDepth = enable; }
+		bool IsDepthReorderingEnabled() const{ return reorderForDepth; }
+
+		size_t Size() const{ return drawCalls.size(); }
+		bool IsEmpty() const{ return drawCalls.empty(); }
+		const DrawCall& operator[](size_t i) const{ return drawCalls[i]; }
+
+		// Order the renderer processes the draws in. Submission order, unless depth reordering is enabled
+		// Then runs of consecutive draws that write color and depth with the same strict test (Less or Greater) are sorted
+		// by cull mode and then roughly front-to-back, so that later draws get rejected early
+		// Every other draw keeps its place and acts as a barrier. The *Equal tests are there for draws that depend on
+		// what was drawn before them at the same depth, and depth-only draws decide which color survives
+		void BuildExecutionOrder(std::vector<uint32_t>& outOrder) const;
+
+	private:
+		std::vector<DrawCall> drawCalls;
+		bool reorderForDepth = false;
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <GCore/Math/Matrix.hpp>
+#include <GCore/Math/Vector.hpp>
+
+#include "ClipVertexBuffer.hpp"
+#include "DrawCall.hpp"
+#include "Meshlet.hpp"
+#include "MeshView.hpp"
+
+namespace RS::Raster
+{
+	// Cull stage - runs on transformed vertices before anything gets assembled, clipped or projected
+	// Appends triangleBase + t for every triangle t in [begin, end) that can't be thrown away yet to survivors, in order
+	// The mesh's vertices start at vertexOffset in the vertex buffer. triangleBase lets several instances of a mesh share one list
+	// Removes triangles that are degenerate, fully outside one frustum plane, or facing away according to mode
+	// Orientation is only tested for triangles that don't need clipping, the rest are left to triangle setup
+	void CullTriangles(const ClipVertexBuffer& vertices, const MeshView& mesh, size_t vertexOffset, size_t begin, size_t end, CullMode mode, size_t triangleBase, std::vector<uint32_t>& survivors);
+
+	// Culls whole meshlets before any of their triangles are transformed or assembled
+	// Built per instance from the transform that takes the mesh to clip space, so every test happens in the mesh's own space
+	class MeshletCuller
+	{
+	public:
+		MeshletCuller(const Gadget::Matrix4& transform, CullMode mode_);
+
+		// False if the meshlet's bounding sphere is outside a frustum plane, or its normal cone shows every triangle would be culled for facing
+		bool IsVisible(const Meshlet& meshlet) const;
+
+	private:
+		std::array<Gadget::Vector4, 6> planes;	// Dot(plane, position) >= 0 inside
+		Gadget::Vector4 eye;					// Homogeneous, so w is 0 for orthographic projections
+		CullMode mode;
+	};
+}
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 
-#include <GCore/Graphics/MeshData.hpp>
+#include <GCore/Graphics/Color.hpp>
 #include <GCore/Math/Matrix.hpp>
 
+#include "MeshView.hpp"
+#include "Texture.hpp"
+
 namespace RS
 {
 	enum class CullMode : uint8_t
@@ -29,13 +33,33 @@ namespace RS
 	class DrawCall
 	{
 	public:
-		DrawCall(const Gadget::MeshData& mesh_, Gadget::Matrix4 transform_ = Gadget::Matrix4::Identity()) : mesh(mesh_), mode(CullMode::CCW), writeDepth(true), depthMode(DepthTestMode::Less), transform(transform_), debugCheckerboard(false){}
+		DrawCall(MeshView mesh_, Gadget::Matrix4 transform_ = Gadget::Matrix4::Identity()) : mesh(mesh_), mode(CullMode::CCW), writeDepth(true), writeColor(true), depthMode(DepthTestMode::Less), transform(transform_), perspectiveCorrect(true), debugCheckerboard(false), texture(nullptr), textureFilter(TextureFilter::Trilinear){}
+
+		// Draws the mesh once per instance transform. Each one is applied before transform, which would usually be the view projection
+		// instanceColors is optional, if it's set it needs one color per instance, which tints that instance's vertex colors
+		// Both spans have to stay alive until the draw has been rendered
+		DrawCall(MeshView mesh_, std::span<const Gadget::Matrix4> instanceTransforms_, std::span<const Gadget::Color> instanceColors_ = {}, Gadget::Matrix4 transform_ = Gadget::Matrix4::Identity()) : DrawCall(mesh_, transform_)
+		{
+			instanceTransforms = instanceTransforms_;
+			instanceColors = instanceColors_;
+		}
 
-		const Gadget::MeshData& mesh;
+		MeshView mesh; // Has to stay alive until the draw has been rendered
 		CullMode mode;
 		bool writeDepth;
+		bool writeColor; // Off for depth-only passes
 		DepthTestMode depthMode;
 		Gadget::Matrix4 transform;
+		bool perspectiveCorrect; // Interpolates vertex colors with perspective correction, costs a reciprocal per pixel
 		bool debugCheckerboard;
+		const Texture* texture; // Optional, modulates the vertex colors. Needs mesh.texCoords, and has to stay alive until the draw has been rendered
+		TextureFilter textureFilter;
+
+		std::span<const Gadget::Matrix4> instanceTransforms;
+		std::span<const Gadget::Color> instanceColors;
+
+		bool IsInstanced() const{ return !instanceTransforms.empty(); }
+		size_t NumInstances() const{ return IsInstanced() ? instanceTransforms.size() : 1; }
+		bool IsTextured() const{ return texture != nullptr && !mesh.texCoords.empty(); }
 	};
 }
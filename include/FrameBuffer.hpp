@@ -1,34 +1,75 @@
 #pragma once
 
 #include <cstdint>
+#include <limits>
+#include <vector>
 
 #include <GCore/Graphics/Color.hpp>
 
+#include "HiZBuffer.hpp"
+#include "PixelFormat.hpp"
 #include "RenderTarget.hpp"
+#include "TileBinner.hpp"
 
 namespace RS
 {
 	class FrameBuffer
 	{
 	public:
+#if defined(RS_COLOR_FORMAT_RGBA8)
+		using ColorT = PixelRGBA8;
+#else
+		using ColorT = PixelBGRA8;
+#endif
 		using DepthT = uint32_t;
+		using ColorTarget = RenderTarget<ColorT, FrameBufferLayout>;
+		using DepthTarget = RenderTarget<DepthT, FrameBufferLayout>;
 
-		FrameBuffer(uint16_t width_, uint16_t height_) : width(width_), height(height_), color(width_, height_, Gadget::Color(0.0, 0.0, 0.0)), depth(width_, height_, std::numeric_limits<DepthT>::max()){}
+		FrameBuffer(uint16_t width_, uint16_t height_);
 
-		RenderTarget<Gadget::Color> color;
-		RenderTarget<DepthT> depth;
+		ColorTarget color;
+		DepthTarget depth;
+		HiZBuffer hiZ; // Kept up to date by Clear and the raster stage, which have to be the only things writing to depth
 
-		void Clear(const Gadget::Color& color_ = Gadget::Color(0.0, 0.0, 0.0, 0.0), DepthT depth_ = std::numeric_limits<DepthT>::max())
+		// Doesn't touch any pixels, every tile just remembers that it still has to be cleared
+		// Tiles are filled in when the raster stage first draws to them, and the color of any tile left untouched when the frame is presented
+		void Clear(const Gadget::Color& color_ = Gadget::Color(0.0, 0.0, 0.0, 0.0), DepthT depth_ = std::numeric_limits<DepthT>::max());
+
+		// Applies any clear still pending on the tile. Must be called before reading or writing pixels in it
+		void ResolveTile(const TileRect& tile)
 		{
-			color.Clear(color_);
-			depth.Clear(depth_);
+			auto& pending = pendingClears[GetTileIndex(tile)];
+			if (pending != 0)
+			{
+				ApplyPendingClear(tile, pending);
+			}
 		}
 
+		// Applies every pending color clear, i.e. before the color target gets presented
+		// Depth clears stay pending until something draws to the tile
+		void ResolveColor();
+
 		uint16_t Width() const{ return width; }
 		uint16_t Height() const{ return height; }
 
 	private:
+		enum PendingClear : uint8_t
+		{
+			PendingColor = 1 << 0,
+			PendingDepth = 1 << 1
+		};
+
 		uint16_t width;
 		uint16_t height;
+		int32_t tilesX;
+
+		std::vector<uint8_t> pendingClears; // PendingClear flags per tile, written only by the thread that owns the tile
+		ColorT clearColor{};
+		DepthT clearDepth = std::numeric_limits<DepthT>::max();
+
+		size_t GetTileIndex(const TileRect& tile) const{ return (static_cast<size_t>(tile.minY / TileBinner::TileSize) * tilesX) + (tile.minX / TileBinner::TileSize); }
+		TileRect GetTileRect(size_t tile) const;
+
+		void ApplyPendingClear(const TileRect& tile, uint8_t& pending);
 	};
 }
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace RS
+{
+	enum class Scene : uint8_t
+	{
+		Teapot,
+		Cube,
+		Rect
+	};
+
+	struct HeadlessOptions
+	{
+		Scene scene = Scene::Teapot;
+		uint32_t numFrames = 100;
+		uint16_t width = 800;
+		uint16_t height = 600;
+		bool printStatistics = false; // Per frame averages of the renderer's pipeline statistics
+
+		// Frames in captureFrames get written here. A {} in the path is replaced with the frame number
+		std::string outputPath;
+		std::vector<uint32_t> captureFrames;
+	};
+
+	// Renders a fixed number of frames into an in-memory frame buffer without creating a window, then prints timings
+	// The scene animates with a fixed time step, so every run renders exactly the same frames
+	// Returns the process exit code
+	int RunHeadless(const HeadlessOptions& options);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "DrawCall.hpp"
+#include "RenderTarget.hpp"
+#include "TileBinner.hpp"
+
+namespace RS
+{
+	// Which 8x8 blocks of a tile a triangle needs to be rasterized in. Bit (blockY * 8) + blockX, relative to the tile
+	struct BlockMask
+	{
+		uint64_t visible = ~uint64_t{ 0 };	// Some pixel in the block may pass the depth test
+		uint64_t accepted = 0;				// Every pixel in the block passes, so the depth buffer doesn't have to be read
+		uint64_t covered = 0;				// Every pixel center in the block is inside the triangle, so the edge functions don't have to be tested
+	};
+
+	// Coarse depth buffer holding the min and max depth of every 8x8 pixel block
+	// Blocks are grouped by screen tile, so all of a tile's blocks fit in one mask and only the thread rasterizing the tile touches them
+	// Depth writes widen the bounds without reading the depth buffer. Blocks that have been written a few times since they were
+	// last scanned get rescanned, but only when exact bounds could reject the triangle being tested
+	class HiZBuffer
+	{
+	public:
+		static constexpr int32_t BlockSize = 8;
+		static constexpr int32_t BlocksPerTileSide = TileBinner::TileSize / BlockSize;
+		static_assert(BlocksPerTileSide * BlocksPerTileSide == 64, "A tile's blocks have to fit in a BlockMask");
+
+		HiZBuffer(uint16_t width_, uint16_t height_, uint32_t depth);
+
+		void Clear(uint32_t depth);
+
+		// Tests the triangle's depth range against every block it overlaps in the tile
+		// Blocks outside overlapped are never visible, and their bounds are never refreshed
+		BlockMask Classify(const TileRect& tile, const BinnedTriangle& tri, DepthTestMode mode, const RenderTarget<uint32_t, FrameBufferLayout>& depth, uint64_t overlapped = ~uint64_t{ 0 });
+
+		// Has to be called after rasterizing a triangle that writes depth, with the blocks Classify returned for it
+		void Update(const TileRect& tile, const BlockMask& blocks, const BinnedTriangle& tri, DepthTestMode mode);
+
+	private:
+		// Scanning a block reads all 64 of its depths, so it has to be written this many times before that's worth trying again
+		static constexpr uint8_t UpdatesBeforeRefresh = 8;
+
+		struct alignas(64) TileBounds
+		{
+			std::array<uint32_t, 64> minDepth;
+			std::array<uint32_t, 64> maxDepth;
+			std::array<uint8_t, 64> updates; // Since the block was last scanned, saturating
+		};
+
+		std::vector<TileBounds> tiles;
+		int32_t tilesX;
+
+		size_t GetTileIndex(const TileRect& tile) const{ return (static_cast<size_t>(tile.minY / TileBinner::TileSize) * tilesX) + (tile.minX / TileBinner::TileSize); }
+
+		void Refresh(const TileRect& tile, TileBounds& bounds, int block, const RenderTarget<uint32_t, FrameBufferLayout>& depth) const;
+	};
+}
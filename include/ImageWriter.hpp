@@ -0,0 +1,18 @@
+#pragma once
+
+#include <filesystem>
+
+#include "FrameBuffer.hpp"
+
+namespace RS
+{
+	// Writes the frame buffer's color target, picking the format from the extension (.png or .ppm)
+	// Pending clears have to be resolved first with FrameBuffer::ResolveColor
+	bool WriteImage(const std::filesystem::path& path, const FrameBuffer& frameBuffer);
+
+	// Binary PPM (P6), 8 bits per channel
+	bool WritePpm(const std::filesystem::path& path, const FrameBuffer& frameBuffer);
+
+	// 8-bit RGB PNG. Uses uncompressed deflate blocks, so files are large but nothing beyond the standard library is needed
+	bool WritePng(const std::filesystem::path& path, const FrameBuffer& frameBuffer);
+}
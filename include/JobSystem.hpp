@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RS
+{
+	// Number of jobs still in flight. Waiting on a counter returns once it reaches zero
+	class JobCounter
+	{
+	public:
+		JobCounter() = default;
+
+		bool IsDone() const{ return value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<int64_t> value{ 0 };
+	};
+
+	// Persistent worker threads with one work-stealing queue per thread
+	// The thread that waits on a counter runs jobs too instead of idling
+	class JobSystem
+	{
+	public:
+		// numThreads includes the calling thread, so numThreads - 1 workers are started
+		explicit JobSystem(uint32_t numThreads = std::thread::hardware_concurrency());
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Splits [0, count) into ranges of at most rangeSize and runs func(begin, end) on each of them
+		// Blocks until every range is done
+		template <typename Func>
+		void ParallelFor(size_t count, size_t rangeSize, const Func& func)
+		{
+			JobCounter counter;
+			Dispatch(count, rangeSize, [](const void* context, size_t begin, size_t end)
+			{
+				(*static_cast<const Func*>(context))(begin, end);
+			}, &func, counter, 0);
+			Wait(counter);
+		}
+
+		// Queues func() to run on another thread without waiting for it
+		// func has to stay alive until the counter is done
+		template <typename Func>
+		void Run(const Func& func, JobCounter& counter)
+		{
+			Dispatch(1, 1, [](const void* context, size_t /* begin */, size_t /* end */)
+			{
+				(*static_cast<const Func*>(context))();
+			}, &func, counter, 1);
+		}
+
+		// Helps run jobs until the counter reaches zero
+		void Wait(JobCounter& counter);
+
+		uint32_t NumThreads() const{ return static_cast<uint32_t>(queues.size() - 1); }
+
+		// Per-thread data indexed by CurrentThreadIndex needs this many slots
+		uint32_t NumThreadSlots() const{ return static_cast<uint32_t>(queues.size()); }
+
+		// Index in [0, NumThreadSlots()) of the calling thread, relative to this JobSystem
+		// The thread that created it is 0 and its workers are 1 to NumThreads() - 1. Any other thread, including workers of
+		// another JobSystem, gets the last slot, so only one such thread should wait on this JobSystem at a time
+		uint32_t CurrentThreadIndex() const{ return static_cast<uint32_t>(GetQueueIndex()); }
+
+	private:
+		using JobFunction = void(*)(const void* context, size_t begin, size_t end);
+
+		struct Job
+		{
+			JobFunction function = nullptr;
+			const void* context = nullptr;
+			size_t begin = 0;
+			size_t end = 0;
+			JobCounter* counter = nullptr;
+		};
+
+		// The owning thread pushes and pops at the back, other threads steal from the front
+		struct alignas(64) WorkQueue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+
+			void Push(const Job& job);
+			bool Pop(Job& outJob);
+			bool Steal(Job& outJob);
+		};
+
+		std::vector<WorkQueue> queues; // Queue 0 belongs to the thread that created the JobSystem, the last one to threads it doesn't know
+		std::vector<std::thread> workers;
+		std::thread::id ownerThread = std::this_thread::get_id();
+
+		std::atomic<int64_t> queuedJobs{ 0 };
+		std::atomic<uint64_t> completionEpoch{ 0 };
+		std::atomic<bool> isRunning{ true };
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+
+		// Jobs are spread over the queues starting queueOffset queues after the calling thread's own
+		void Dispatch(size_t count, size_t rangeSize, JobFunction function, const void* context, JobCounter& counter, size_t queueOffset);
+		size_t GetQueueIndex() const;
+		bool TryRunJob(size_t queueIndex);
+		void WorkerLoop(size_t queueIndex);
+	};
+}
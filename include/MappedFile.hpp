@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace RS
+{
+	// Read-only memory mapping of a whole file. Pages are loaded by the OS as they're touched
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile(){ Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// Returns false if the file couldn't be opened or mapped
+		bool Open(const std::filesystem::path& path);
+		void Close();
+
+		bool IsOpen() const{ return data != nullptr; }
+		std::span<const std::byte> Data() const{ return { data, size }; }
+
+	private:
+		const std::byte* data = nullptr;
+		size_t size = 0;
+
+#if defined(RS_PLATFORM_WIN32)
+		void* fileHandle = nullptr;
+		void* mappingHandle = nullptr;
+#endif
+	};
+}
@@ -4,7 +4,7 @@
 
 namespace RS
 {
-	Gadget::MeshData GetRectMesh()
+	inline Gadget::MeshData GetRectMesh()
 	{
 		auto rectMesh = Gadget::MeshData();
 		rectMesh.vertices.reserve(4);
@@ -29,7 +29,7 @@ namespace RS
 		return rectMesh;
 	}
 
-	Gadget::MeshData GetCubeMesh()
+	inline Gadget::MeshData GetCubeMesh()
 	{
 		auto cubeMesh = Gadget::MeshData();
 		cubeMesh.vertices.emplace_back(Gadget::Vector4(-1.0, -1.0, -1.0, 1.0));
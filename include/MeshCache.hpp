@@ -0,0 +1,44 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+#include <GCore/Graphics/MeshData.hpp>
+
+#include "MappedFile.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshView.hpp"
+
+namespace RS
+{
+	// Every mesh of a model, either mapped straight from its cache file or, if the cache couldn't be written, loaded into memory
+	class CachedModel
+	{
+	public:
+		CachedModel() = default;
+
+		CachedModel(const CachedModel&) = delete;
+		CachedModel& operator=(const CachedModel&) = delete;
+		CachedModel(CachedModel&&) noexcept = default;
+		CachedModel& operator=(CachedModel&&) noexcept = default;
+
+		// Views point into this object, so they're only valid while it's alive
+		const std::vector<MeshView>& Meshes() const{ return meshes; }
+		bool IsEmpty() const{ return meshes.empty(); }
+		bool IsMapped() const{ return file.IsOpen(); }
+
+	private:
+		friend CachedModel LoadCachedModel(const std::filesystem::path& sourcePath, const std::filesystem::path& cachePath);
+
+		MappedFile file;
+		std::vector<OptimizedMesh> fallback;
+		std::vector<MeshView> meshes;
+	};
+
+	// Loads a model through a binary cache next to the source file, at sourcePath + ".rsmesh"
+	// The first load imports the source through Gadget::MeshLoader, runs it through OptimizeMesh and writes the cache
+	// Later loads just map it without any parsing, optimizing or copying
+	// The cache is rebuilt whenever the source changes, or it was written by a build with a different vertex layout
+	CachedModel LoadCachedModel(const std::filesystem::path& sourcePath);
+	CachedModel LoadCachedModel(const std::filesystem::path& sourcePath, const std::filesystem::path& cachePath);
+}
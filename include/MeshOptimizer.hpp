@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <GCore/Graphics/MeshData.hpp>
+
+#include "Meshlet.hpp"
+#include "MeshView.hpp"
+
+namespace RS
+{
+	struct MeshOptimizerOptions
+	{
+		uint32_t cacheSize = 32;		// Vertices the optimized order assumes are still recent
+		uint32_t maxMeshletVertices = 64;
+		uint32_t maxMeshletTriangles = 124;
+	};
+
+	// A mesh along with the meshlets covering its triangles
+	struct OptimizedMesh
+	{
+		Gadget::MeshData mesh;
+		std::vector<Meshlet> meshlets;
+		MeshBounds bounds;
+
+		MeshView View() const{ return MeshView(mesh.vertices, mesh.indices, meshlets, {}, bounds); }
+	};
+
+	// Merges vertices that are bit-for-bit identical and points the indices at the one that's kept. Returns how many were removed
+	// Loaders for formats like STL emit three unique vertices per triangle, this is what lets their triangles share vertices at all
+	size_t WeldVertices(Gadget::MeshData& mesh);
+
+	// Reorders triangles so vertices are reused while they're still recent (Forsyth's linear-speed vertex cache optimization)
+	// The vertex stage transforms every vertex once regardless, but the triangle stages read clip vertices in index order
+	void OptimizeVertexCache(std::span<uint32_t> indices, size_t numVertices, uint32_t cacheSize = 32);
+
+	// Reorders vertices by their first use in the index buffer, and drops the ones nothing uses
+	void OptimizeVertexFetch(Gadget::MeshData& mesh);
+
+	// Splits the triangles into meshlets in index buffer order, so the index order should already be optimized
+	std::vector<Meshlet> BuildMeshlets(const Gadget::MeshData& mesh, uint32_t maxVertices = 64, uint32_t maxTriangles = 124);
+
+	// Reorders meshlets, and their triangles in the index buffer along with them, so the ones most likely to cover the rest of the mesh come first
+	// Those face away from the mesh's center, the same measure Sander et al. use for view-independent overdraw reduction
+	void OptimizeOverdraw(Gadget::MeshData& mesh, std::vector<Meshlet>& meshlets);
+
+	// Welding, vertex cache order, meshlets, overdraw order and vertex fetch order, in that order
+	OptimizedMesh OptimizeMesh(Gadget::MeshData mesh, const MeshOptimizerOptions& options = {});
+}
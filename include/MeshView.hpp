@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+
+#include <GCore/Graphics/MeshData.hpp>
+#include <GCore/Graphics/Vertex.hpp>
+
+#include "Meshlet.hpp"
+
+namespace RS
+{
+	// Texture coordinates of one vertex. Gadget::Vertex doesn't have any, so meshes that get textured carry them alongside
+	struct TexCoord
+	{
+		float u = 0.0f;
+		float v = 0.0f;
+	};
+
+	// Axis-aligned box around every vertex of a mesh, w is 1
+	struct MeshBounds
+	{
+		Gadget::Vector4 min;
+		Gadget::Vector4 max;
+	};
+
+	// Empty meshes get an empty box at the origin
+	inline MeshBounds ComputeMeshBounds(std::span<const Gadget::Vertex> vertices)
+	{
+		if (vertices.empty())
+		{
+			return MeshBounds{ Gadget::Vector4(0.0, 0.0, 0.0, 1.0), Gadget::Vector4(0.0, 0.0, 0.0, 1.0) };
+		}
+
+		auto boundsMin = vertices[0].position;
+		auto boundsMax = vertices[0].position;
+		for (const auto& vertex : vertices)
+		{
+			boundsMin = Gadget::Vector4(std::min(boundsMin.x, vertex.position.x), std::min(boundsMin.y, vertex.position.y), std::min(boundsMin.z, vertex.position.z), 1.0);
+			boundsMax = Gadget::Vector4(std::max(boundsMax.x, vertex.position.x), std::max(boundsMax.y, vertex.position.y), std::max(boundsMax.z, vertex.position.z), 1.0);
+		}
+
+		return MeshBounds{ boundsMin, boundsMax };
+	}
+
+	// Non-owning view of a mesh's vertices and indices
+	// Lets draws reference meshes that don't live in a Gadget::MeshData, like ones mapped straight from the mesh cache
+	// Building a view walks every vertex for its bounds, unless they're passed in, so views should be built once rather than per draw
+	struct MeshView
+	{
+		MeshView() = default;
+		MeshView(const Gadget::MeshData& mesh) : vertices(mesh.vertices), indices(mesh.indices), bounds(ComputeMeshBounds(mesh.vertices)){}
+		MeshView(std::span<const Gadget::Vertex> vertices_, std::span<const uint32_t> indices_, std::span<const Meshlet> meshlets_ = {}, std::span<const TexCoord> texCoords_ = {}) : MeshView(vertices_, indices_, meshlets_, texCoords_, ComputeMeshBounds(vertices_)){}
+		MeshView(std::span<const Gadget::Vertex> vertices_, std::span<const uint32_t> indices_, std::span<const Meshlet> meshlets_, std::span<const TexCoord> texCoords_, const MeshBounds& bounds_) : vertices(vertices_), indices(indices_), meshlets(meshlets_), texCoords(texCoords_), bounds(bounds_){}
+
+		std::span<const Gadget::Vertex> vertices;
+		std::span<const uint32_t> indices;
+		std::span<const Meshlet> meshlets; // Optional. If set they have to cover every triangle, and draws cull whole meshlets before the cull stage
+		std::span<const TexCoord> texCoords; // Optional, one per vertex. The mesh optimizer reorders vertices without them, so they only line up with meshes it hasn't touched
+
+		MeshBounds bounds; // Instanced draws cull against it, so it has to be rebuilt if the vertices change
+
+		size_t NumTriangles() const{ return indices.size() / 3; }
+	};
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+#include <GCore/Math/Vector.hpp>
+
+namespace RS
+{
+	// A small cluster of a mesh's triangles, with bounds for culling all of them at once
+	// Meshlets cover consecutive triangles of the index buffer, and a mesh's meshlets are stored in index buffer order
+	struct Meshlet
+	{
+		uint32_t triangleOffset = 0;	// First triangle, not index
+		uint32_t triangleCount = 0;
+
+		Gadget::Vector4 center;			// Bounding sphere of every vertex, w is 1
+		double radius = 0.0;
+
+		// Every triangle's geometric normal ((v1 - v0) x (v2 - v0)) is within the cone around coneAxis, w is 0
+		// coneCutoff is the sine of the cone's half angle. Cones of 90 degrees or wider can't be used for culling, their cutoff is above 1
+		Gadget::Vector4 coneAxis;
+		double coneCutoff = 2.0;
+
+		bool HasCone() const{ return coneCutoff <= 1.0; }
+	};
+}
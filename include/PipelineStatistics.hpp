@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+
+namespace RS
+{
+	// Counts of what went through each pipeline stage, gathered by the renderer when statistics are enabled
+	struct PipelineStatistics
+	{
+		uint64_t inputPrimitives = 0;			// Triangles of every submitted instance
+		uint64_t culledPrimitives = 0;			// Dropped by the instance bounds check, meshlet culling or the cull stage (facing, degenerate or off-screen)
+		uint64_t clippedPrimitives = 0;			// Triangles that had to go through Raster::ClipTriangle
+		uint64_t clipOutputPrimitives = 0;		// Triangles Raster::ClipTriangle emitted
+		uint64_t setupRejectedPrimitives = 0;	// Dropped in triangle setup, i.e. back-facing after clipping or not covering any pixel centers
+		uint64_t binnedPrimitives = 0;			// Triangles that made it into the tile bins
+		uint64_t hiZRejectedTiles = 0;			// Triangle and tile pairs skipped entirely because the Hi-Z buffer showed them hidden
+		uint64_t edgeRejectedTiles = 0;			// Triangle and tile pairs skipped because only the triangle's bounds overlap the tile, see Raster::ClassifyCoverage
+		uint64_t edgeAcceptedBlocks = 0;		// 8x8 blocks a large triangle covers completely, rasterized without edge tests
+		uint64_t coveredPixels = 0;				// Pixels that passed the edge test, in blocks the Hi-Z buffer didn't reject
+		uint64_t depthTestsPassed = 0;
+		uint64_t depthTestsFailed = 0;
+		uint64_t depthTestsSkipped = 0;			// Passed without being tested, because the Hi-Z buffer accepted their whole block
+		uint64_t colorWrites = 0;
+
+		PipelineStatistics& operator+=(const PipelineStatistics& other)
+		{
+			inputPrimitives += other.inputPrimitives;
+			culledPrimitives += other.culledPrimitives;
+			clippedPrimitives += other.clippedPrimitives;
+			clipOutputPrimitives += other.clipOutputPrimitives;
+			setupRejectedPrimitives += other.setupRejectedPrimitives;
+			binnedPrimitives += other.binnedPrimitives;
+			hiZRejectedTiles += other.hiZRejectedTiles;
+			edgeRejectedTiles += other.edgeRejectedTiles;
+			edgeAcceptedBlocks += other.edgeAcceptedBlocks;
+			coveredPixels += other.coveredPixels;
+			depthTestsPassed += other.depthTestsPassed;
+			depthTestsFailed += other.depthTestsFailed;
+			depthTestsSkipped += other.depthTestsSkipped;
+			colorWrites += other.colorWrites;
+			return *this;
+		}
+
+		// Calls func(name, value) for every counter, in declaration order
+		template <typename Func>
+		void ForEachCounter(const Func& func) const
+		{
+			func("inputPrimitives", inputPrimitives);
+			func("culledPrimitives", culledPrimitives);
+			func("clippedPrimitives", clippedPrimitives);
+			func("clipOutputPrimitives", clipOutputPrimitives);
+			func("setupRejectedPrimitives", setupRejectedPrimitives);
+			func("binnedPrimitives", binnedPrimitives);
+			func("hiZRejectedTiles", hiZRejectedTiles);
+			func("edgeRejectedTiles", edgeRejectedTiles);
+			func("edgeAcceptedBlocks", edgeAcceptedBlocks);
+			func("coveredPixels", coveredPixels);
+			func("depthTestsPassed", depthTestsPassed);
+			func("depthTestsFailed", depthTestsFailed);
+			func("depthTestsSkipped", depthTestsSkipped);
+			func("colorWrites", colorWrites);
+		}
+	};
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <GCore/Graphics/Color.hpp>
+
+namespace RS
+{
+	// 8 bits per channel, red first in memory
+	struct PixelRGBA8
+	{
+		uint8_t r;
+		uint8_t g;
+		uint8_t b;
+		uint8_t a;
+
+		// Bit offsets of each channel when the pixel is read as a little-endian uint32_t
+		static constexpr int RedShift = 0;
+		static constexpr int GreenShift = 8;
+		static constexpr int BlueShift = 16;
+		static constexpr int AlphaShift = 24;
+	};
+
+	// 8 bits per channel, blue first in memory. Same layout as SDL's ARGB8888 window surfaces on little-endian machines
+	struct PixelBGRA8
+	{
+		uint8_t b;
+		uint8_t g;
+		uint8_t r;
+		uint8_t a;
+
+		static constexpr int RedShift = 16;
+		static constexpr int GreenShift = 8;
+		static constexpr int BlueShift = 0;
+		static constexpr int AlphaShift = 24;
+	};
+
+	static_assert(sizeof(PixelRGBA8) == sizeof(uint32_t));
+	static_assert(sizeof(PixelBGRA8) == sizeof(uint32_t));
+
+	inline uint8_t PackChannel(float value)
+	{
+		return static_cast<uint8_t>((std::clamp(value, 0.0f, 1.0f) * 255.0f) + 0.5f);
+	}
+
+	inline float UnpackChannel(uint8_t value)
+	{
+		return static_cast<float>(value) / 255.0f;
+	}
+
+	template <typename Pixel>
+	inline Pixel PackColor(const Gadget::Color& color)
+	{
+		Pixel pixel{};
+		pixel.r = PackChannel(color.r);
+		pixel.g = PackChannel(color.g);
+		pixel.b = PackChannel(color.b);
+		pixel.a = PackChannel(color.a);
+		return pixel;
+	}
+
+	template <typename Pixel>
+	inline Gadget::Color UnpackColor(const Pixel& pixel)
+	{
+		return Gadget::Color(UnpackChannel(pixel.r), UnpackChannel(pixel.g), UnpackChannel(pixel.b), UnpackChannel(pixel.a));
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <GCore/Graphics/Color.hpp>
+
+#include "FrameBuffer.hpp"
+
+struct SDL_Surface;
+struct SDL_Window;
+
+namespace RS
+{
+	// GadgetCore doesn't expose its SDL window, but it's the only one we ever create
+	SDL_Window* GetMainSdlWindow();
+
+	// Copies the frame buffer's color target to the window surface
+	// Rows are copied straight across when the surface has the same pixel layout, otherwise SDL converts them in bulk
+	// Tiled frame buffers are de-swizzled on the way, in the same pass as the copy when the surface layout matches
+	// Any part of the surface the frame buffer doesn't cover (i.e. mid-resize) is filled with backgroundColor
+	// Pending clears have to be resolved first with FrameBuffer::ResolveColor
+	void Present(SDL_Window* window, const FrameBuffer& frameBuffer, const Gadget::Color& backgroundColor);
+
+	// Same as Present, but for a surface that was already retrieved on the main thread
+	// Safe to call from a worker thread as long as nothing else touches the surface in the meantime
+	void CopyToSurface(SDL_Surface* surface, const FrameBuffer& frameBuffer, const Gadget::Color& backgroundColor);
+
+	// Returns true if frame buffers can render straight into the surface's memory
+	bool CanRenderToSurface(const SDL_Surface* surface, const FrameBuffer& frameBuffer);
+}
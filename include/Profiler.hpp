@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace RS
+{
+	enum class ProfileStage : uint8_t
+	{
+		Frame,		// Whole main loop iteration
+		Events,		// Window event handling
+		Setup,		// Execution order, instance culling and job ranges
+		Vertex,		// Vertex stage job
+		Cull,		// Cull stage job
+		Clip,		// Geometry stage job - clipping, triangle setup and binning
+		Raster,		// Raster stage job for one tile, depth testing included
+		Clear,		// Filling in pending clears
+		Copy,		// Copying the color target to the window surface
+		Present,	// Everything SwapChain::EndFrame does
+		Idle,		// Threads waiting for jobs
+
+		Count
+	};
+
+	const char* ToString(ProfileStage stage);
+
+	// Log-linear histogram of durations in nanoseconds, accurate to within 25%
+	class ProfileHistogram
+	{
+	public:
+		void Add(uint64_t value)
+		{
+			buckets[GetBucket(value)]++;
+			count++;
+			total += value;
+			max = std::max(max, value);
+		}
+
+		void Merge(const ProfileHistogram& other);
+
+		// Upper bound of the bucket holding the given percentile
+		uint64_t Percentile(double percent) const;
+
+		uint64_t Count() const{ return count; }
+		uint64_t Total() const{ return total; }
+		uint64_t Max() const{ return max; }
+
+	private:
+		static constexpr int SubBucketBits = 2;
+		static constexpr size_t NumBuckets = size_t{ 64 } << SubBucketBits;
+
+		std::array<uint64_t, NumBuckets> buckets{};
+		uint64_t count = 0;
+		uint64_t total = 0;
+		uint64_t max = 0;
+
+		static size_t GetBucket(uint64_t value)
+		{
+			if (value < (uint64_t{ 1 } << SubBucketBits))
+			{
+				return static_cast<size_t>(value);
+			}
+
+			const int msb = std::bit_width(value) - 1;
+			const uint64_t subBucket = (value >> (msb - SubBucketBits)) & ((uint64_t{ 1 } << SubBucketBits) - 1);
+			return (static_cast<size_t>(msb - SubBucketBits + 1) << SubBucketBits) + subBucket;
+		}
+	};
+
+	// Collects scoped timings per thread. Only ever built in with RS_PROFILING, use the RS_PROFILE_ macros below
+	// Every thread records into its own buffers, so the report and trace can only be written while nothing is rendering
+	namespace Profiler
+	{
+#if defined(RS_PROFILING_ENABLED)
+		constexpr bool IsEnabled = true;
+#else
+		constexpr bool IsEnabled = false;
+#endif
+
+		void SetThreadName(std::string name);
+
+		// Marks the start of the next frame on the main thread. Anything recorded before the first call isn't part of any frame
+		void BeginFrame();
+		uint64_t CurrentFrame();
+
+		// Keeps every individual event of frames [firstFrame, firstFrame + numFrames) for WriteTrace
+		void CaptureFrames(uint64_t firstFrame, uint64_t numFrames);
+
+		void Record(ProfileStage stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+		// Per stage percentiles over every recorded frame, and how busy each thread was
+		void PrintReport();
+
+		// Chrome/Perfetto trace JSON of the captured frames, one track per thread
+		bool WriteTrace(const std::filesystem::path& path);
+	}
+
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(ProfileStage stage_) : stage(stage_), start(std::chrono::steady_clock::now()){}
+		~ProfileScope(){ Profiler::Record(stage, start, std::chrono::steady_clock::now()); }
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		ProfileStage stage;
+		std::chrono::steady_clock::time_point start;
+	};
+}
+
+#define RS_PROFILE_CONCAT_INNER(a, b) a##b
+#define RS_PROFILE_CONCAT(a, b) RS_PROFILE_CONCAT_INNER(a, b)
+
+#if defined(RS_PROFILING_ENABLED)
+	#define RS_PROFILE_SCOPE(stage) const RS::ProfileScope RS_PROFILE_CONCAT(profileScope, __LINE__)(stage)
+	#define RS_PROFILE_BEGIN_FRAME() RS::Profiler::BeginFrame()
+	#define RS_PROFILE_THREAD(name) RS::Profiler::SetThreadName(name)
+#else
+	#define RS_PROFILE_SCOPE(stage) ((void)0)
+	#define RS_PROFILE_BEGIN_FRAME() ((void)0)
+	#define RS_PROFILE_THREAD(name) ((void)0)
+#endif
@@ -1,21 +1,159 @@
 #pragma once
 
-#include <GCore/Graphics/Vertex.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include <GCore/Graphics/Color.hpp>
 #include <GCore/Math/Vector.hpp>
 
+#include "ClipPosition.hpp"
 #include "DrawCall.hpp"
+#include "MeshView.hpp"
 #include "StackVector.hpp"
 
 namespace RS::Raster
 {
-	using Triangle = std::array<Gadget::Vertex, 3>;
+	// Everything clipping has to interpolate, in clip space
+	struct ClipVertex
+	{
+		ClipPosition position;
+		Gadget::Color color;
+		TexCoord texCoord;
+	};
+
+	using Triangle = std::array<ClipVertex, 3>;
 	using ClippedTriangleList = RS::StackVector<Triangle, 12>;
 
-	Gadget::Vertex ClipIntersectEdge(const Gadget::Vertex& v0, const Gadget::Vertex& v1, double value0, double value1);
+	ClipVertex ClipIntersectEdge(const ClipVertex& v0, const ClipVertex& v1, Real value0, Real value1);
+
+	// One bit per clip plane a clip-space position is outside of
+	enum Outcode : uint16_t
+	{
+		OutsideLeft = 1 << 0,
+		OutsideRight = 1 << 1,
+		OutsideBottom = 1 << 2,
+		OutsideTop = 1 << 3,
+		OutsideNear = 1 << 4,
+		OutsideFar = 1 << 5,
+		OutsideGuardLeft = 1 << 6,
+		OutsideGuardRight = 1 << 7,
+		OutsideGuardBottom = 1 << 8,
+		OutsideGuardTop = 1 << 9
+	};
+
+	constexpr uint16_t FrustumOutcodes = OutsideLeft | OutsideRight | OutsideBottom | OutsideTop | OutsideNear | OutsideFar;
+
+	// Planes triangles actually get split against. The x/y frustum planes are handled by the rasterizer's scissoring,
+	// so only triangles that reach past the much wider guard band have to be clipped in x/y
+	constexpr uint16_t ClipOutcodes = OutsideNear | OutsideFar | OutsideGuardLeft | OutsideGuardRight | OutsideGuardBottom | OutsideGuardTop;
 
-	void ClipTriangle(const Triangle& triangle, const Gadget::Vector4& equation, ClippedTriangleList& result);
+	// Guard band size in NDC units. Viewports are at most 65535 pixels across, so positions inside the guard band
+	// stay below 2^25 pixels once projected, well within MaxFixedPointCoordinate
+	constexpr double GuardBandScale = 1024.0;
 
-	ClippedTriangleList ClipTriangle(Triangle inTriangle);
+	uint16_t ComputeOutcode(const ClipPosition& position);
+
+	// A triangle can skip clipping if none of its vertices are outside a clip plane,
+	// and can be thrown away if all of its vertices are outside the same frustum plane
+	inline bool IsTriviallyAccepted(uint16_t outcode0, uint16_t outcode1, uint16_t outcode2){ return ((outcode0 | outcode1 | outcode2) & ClipOutcodes) == 0; }
+	inline bool IsTriviallyRejected(uint16_t outcode0, uint16_t outcode1, uint16_t outcode2){ return (outcode0 & outcode1 & outcode2 & FrustumOutcodes) != 0; }
+
+	// Clips against the near and far planes and the guard band, but only the planes set in outcodes (all vertex outcodes or'd together)
+	ClippedTriangleList ClipTriangle(const Triangle& triangle, uint16_t outcodes);
 
 	bool DepthTest(RS::DepthTestMode mode, uint32_t value, uint32_t reference);
+
+	// DepthTest for callers that know the mode at compile time
+	template <RS::DepthTestMode Mode>
+	inline bool DepthTest(uint32_t value, uint32_t reference)
+	{
+		if constexpr (Mode == RS::DepthTestMode::Always)
+		{
+			return true;
+		}
+		else if constexpr (Mode == RS::DepthTestMode::Never)
+		{
+			return false;
+		}
+		else if constexpr (Mode == RS::DepthTestMode::Less)
+		{
+			return value < reference;
+		}
+		else if constexpr (Mode == RS::DepthTestMode::LessEqual)
+		{
+			return value <= reference;
+		}
+		else if constexpr (Mode == RS::DepthTestMode::Greater)
+		{
+			return value > reference;
+		}
+		else if constexpr (Mode == RS::DepthTestMode::GreaterEqual)
+		{
+			return value >= reference;
+		}
+		else if constexpr (Mode == RS::DepthTestMode::Equal)
+		{
+			return value == reference;
+		}
+		else
+		{
+			return value != reference;
+		}
+	}
+
+	// Largest depth buffer value a Real can hold exactly. Floats can't represent 2^32 - 1, so float pipelines stop 255 short of it
+	constexpr Real MaxQuantizedDepth = std::is_same_v<Real, float> ? static_cast<Real>(4294967040.0) : static_cast<Real>(std::numeric_limits<uint32_t>::max());
+
+	// How far interpolated depth can stray from the plane through the vertices, in depth buffer units
+	// Conservative depth bounds are widened by this much. Doubles stay well below one unit, floats only have 24 bits of mantissa
+	constexpr uint32_t DepthRoundingSlack = std::is_same_v<Real, float> ? (1u << 14) : 1u;
+
+	// Maps NDC z to the full range of a 32-bit depth buffer
+	inline uint32_t QuantizeDepth(Real z)
+	{
+		const Real half = 0.5;
+		return static_cast<uint32_t>((half + half * std::clamp<Real>(z, -1, 1)) * MaxQuantizedDepth);
+	}
+
+	// Vertex positions are snapped to 28.4 fixed point before rasterization
+	constexpr int32_t SubPixelBits = 4;
+	constexpr int64_t SubPixelScale = int64_t{ 1 } << SubPixelBits;
+
+	// Snapped positions must stay in this range so that edge functions can't overflow
+	constexpr double MaxFixedPointCoordinate = static_cast<double>(1 << 26);
+
+	// Edge function in fixed point, set up so that stepping between pixels is just an add
+	// Values are >= 0 for pixels that should be covered, including the top-left fill rule bias
+	struct EdgeFunction
+	{
+		int64_t stepX = 0; // Change in value when moving one pixel right
+		int64_t stepY = 0; // Change in value when moving one pixel down
+		int64_t origin = 0; // Value at the center of pixel (0, 0)
+
+		inline int64_t Evaluate(int32_t x, int32_t y) const{ return origin + (stepX * x) + (stepY * y); }
+	};
+
+	// Attribute that's linear in screen space, set up once per triangle so pixels only need a few multiply-adds
+	// The origin is at the triangle's top left pixel rather than pixel (0, 0), so small triangles far from it don't lose precision
+	struct AttributePlane
+	{
+		Real stepX = 0; // Change in value when moving one pixel right
+		Real stepY = 0; // Change in value when moving one pixel down
+		Real origin = 0; // Value at the center of the triangle's (minX, minY) pixel
+
+		inline Real Evaluate(int32_t dx, int32_t dy) const{ return origin + (stepX * dx) + (stepY * dy); }
+	};
+
+	int64_t ToFixedPoint(double value);
+
+	// Sets up the edge function for the edge going from v0 to v1, in 28.4 fixed point
+	// Assumes the triangle is wound so that its area is positive
+	EdgeFunction SetupEdge(int64_t x0, int64_t y0, int64_t x1, int64_t y1);
+
+	// Plane through values a0, a1 and a2 at the vertices, with its origin at pixel (x, y)
+	// Built from the same edge functions as coverage, so it matches barycentric interpolation fill rule bias included
+	AttributePlane SetupAttribute(const std::array<EdgeFunction, 3>& edges, Real invArea, int32_t x, int32_t y, Real a0, Real a1, Real a2);
 }
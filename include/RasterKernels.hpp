@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+
+#include <GCore/Graphics/Color.hpp>
+
+#include "DrawCall.hpp"
+#include "FrameBuffer.hpp"
+#include "PipelineStatistics.hpp"
+#include "Texture.hpp"
+#include "TileBinner.hpp"
+
+namespace RS::Raster
+{
+	// Draw and triangle state the kernels are specialized on, so their inner loops never branch on any of it
+	struct PipelineState
+	{
+		DepthTestMode depthMode = DepthTestMode::Less;
+		bool writeDepth = true;
+		bool writeColor = true;
+		bool debugCheckerboard = false;
+		bool isTextured = false;
+		bool isPerspective = false; // Comes from the triangle rather than the draw, see BinnedTriangle::isPerspective
+
+		static constexpr size_t NumDepthModes = 8;
+		static constexpr size_t Count = NumDepthModes << 5;
+
+		constexpr size_t Index() const
+		{
+			return (static_cast<size_t>(depthMode) << 5) | (writeDepth ? 16 : 0) | (writeColor ? 8 : 0) | (debugCheckerboard ? 4 : 0) | (isTextured ? 2 : 0) | (isPerspective ? 1 : 0);
+		}
+
+		static constexpr PipelineState FromIndex(size_t index)
+		{
+			return PipelineState{ static_cast<DepthTestMode>(index >> 5), (index & 16) != 0, (index & 8) != 0, (index & 4) != 0, (index & 2) != 0, (index & 1) != 0 };
+		}
+
+		static PipelineState FromDraw(const DrawCall& drawCall, bool isPerspective)
+		{
+			return PipelineState{ drawCall.depthMode, drawCall.writeDepth, drawCall.writeColor, drawCall.debugCheckerboard, drawCall.IsTextured(), isPerspective };
+		}
+	};
+
+	static_assert(static_cast<size_t>(DepthTestMode::NotEqual) + 1 == PipelineState::NumDepthModes, "Every depth test mode needs its own kernels");
+
+	// Rasterizes the part of a triangle that overlaps the given tile
+	// Only one thread ever owns a tile, so kernels don't need any synchronization
+	// Pixels in blocks that aren't visible are skipped, and accepted blocks skip the depth test
+	// Pixel counts are added to statistics unless it's null. The sampler is only used by textured kernels
+	using TileKernel = void(*)(const BinnedTriangle& tri, const TileRect& tile, const BlockMask& blocks, FrameBuffer& frameBuffer, const TextureSampler& sampler, PipelineStatistics* statistics);
+
+	// Every permutation of a kernel, indexed by PipelineState::Index()
+	using TileKernelTable = std::array<TileKernel, PipelineState::Count>;
+
+	const TileKernelTable& GetScalarTileKernels();
+
+#ifdef RS_SIMD_ENABLED
+	// 4x1 pixel blocks
+	const TileKernelTable& GetSse41TileKernels();
+
+	// 8x1 pixel blocks
+	const TileKernelTable& GetAvx2TileKernels();
+#endif
+
+	// Picks the widest kernels the CPU we're running on supports
+	const TileKernelTable& SelectTileKernels();
+
+	// Name of the kernels SelectTileKernels picks: "avx2", "sse4.1" or "scalar"
+	const char* GetSelectedKernelName();
+
+	// Triangles whose bounds are at most this many pixels on a side have their few pixel centers tested during setup,
+	// so the ones that cover none are dropped before any attributes are set up, see SetupTriangle
+	constexpr int32_t SmallTriangleSize = 4;
+
+	// Triangles with bounds wider or taller than this are classified block by block before they're rasterized
+	constexpr int32_t LargeTriangleSize = 2 * HiZBuffer::BlockSize;
+
+	inline bool IsLargeTriangle(const BinnedTriangle& tri){ return tri.maxX - tri.minX > LargeTriangleSize || tri.maxY - tri.minY > LargeTriangleSize; }
+
+	// Which of a tile's 8x8 blocks a triangle overlaps at all, and which it covers completely. Bits as in BlockMask
+	struct BlockCoverage
+	{
+		uint64_t overlapped = 0;
+		uint64_t covered = 0;
+	};
+
+	// Evaluates the edge functions at the corners of every block in the triangle's bounds,
+	// so blocks in the empty parts of a large triangle's bounds are never visited pixel by pixel
+	BlockCoverage ClassifyCoverage(const BinnedTriangle& tri, const TileRect& tile);
+
+	// SIMD kernels keep edge values in 32-bit lanes, which only works if stepping across a block can't overflow
+	// Triangles with steeper edges than this (which are enormous) go through the scalar kernel instead
+	constexpr int64_t MaxSimdEdgeStep = int64_t{ 1 } << 26;
+	constexpr int64_t MaxSimdEdgeValue = int64_t{ 1 } << 30;
+
+	inline bool CanUseSimdKernel(const BinnedTriangle& tri)
+	{
+		for (const auto& edge : tri.edges)
+		{
+			if (edge.stepX >= MaxSimdEdgeStep || edge.stepX <= -MaxSimdEdgeStep)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Counts one block of lanes. Bits of coverageMask and passMask are lanes inside the triangle and lanes that passed the depth test
+	inline void AddPixelStatistics(PipelineStatistics& statistics, int coverageMask, int passMask, bool accepted, bool writeColor)
+	{
+		const auto covered = static_cast<uint64_t>(std::popcount(static_cast<uint32_t>(coverageMask)));
+		const auto passed = static_cast<uint64_t>(std::popcount(static_cast<uint32_t>(passMask)));
+
+		statistics.coveredPixels += covered;
+		statistics.depthTestsSkipped += accepted ? covered : 0;
+		statistics.depthTestsPassed += passed;
+		statistics.depthTestsFailed += covered - passed;
+		statistics.colorWrites += writeColor ? passed : 0;
+	}
+
+	// Texture LOD at pixel (dx, dy) relative to the triangle's top left pixel, from how far u and v move between neighbouring pixels
+	// Kernels pick it once per block of pixels rather than per pixel, it changes slowly across a triangle
+	inline float TextureLod(const BinnedTriangle& tri, bool isPerspective, int32_t dx, int32_t dy, const Texture& texture)
+	{
+		const auto& uPlane = tri.texCoord[0];
+		const auto& vPlane = tri.texCoord[1];
+		double dudx = uPlane.stepX;
+		double dudy = uPlane.stepY;
+		double dvdx = vPlane.stepX;
+		double dvdy = vPlane.stepY;
+
+		// Quotient rule on (u / w) / (1 / w)
+		if (isPerspective)
+		{
+			const double invW = tri.invW.Evaluate(dx, dy);
+			const double scale = 1.0 / (invW * invW);
+			const double u = uPlane.Evaluate(dx, dy);
+			const double v = vPlane.Evaluate(dx, dy);
+			dudx = ((uPlane.stepX * invW) - (u * tri.invW.stepX)) * scale;
+			dudy = ((uPlane.stepY * invW) - (u * tri.invW.stepY)) * scale;
+			dvdx = ((vPlane.stepX * invW) - (v * tri.invW.stepX)) * scale;
+			dvdy = ((vPlane.stepY * invW) - (v * tri.invW.stepY)) * scale;
+		}
+
+		const double width = texture.Width();
+		const double height = texture.Height();
+		const double lengthX = ((dudx * width) * (dudx * width)) + ((dvdx * height) * (dvdx * height));
+		const double lengthY = ((dudy * width) * (dudy * width)) + ((dvdy * height) * (dvdy * height));
+
+		// Half of log2 of the squared length, which saves the square root
+		return static_cast<float>(0.5 * std::log2(std::max(lengthX, lengthY)));
+	}
+
+	// LOD of each depth block in the current row of blocks, so a kernel computes it once per 8x8 block rather than once per row
+	// The first pixel a kernel writes in a block picks it, which is the same pixel for every kernel since they all walk rows top to bottom
+	class BlockLodCache
+	{
+	public:
+		template <typename ComputeLod>
+		float Get(int32_t blockRow, int32_t blockColumn, const ComputeLod& computeLod)
+		{
+			if (blockRow != row)
+			{
+				row = blockRow;
+				valid = 0;
+			}
+
+			const uint32_t bit = 1u << blockColumn;
+			if ((valid & bit) == 0)
+			{
+				valid |= bit;
+				lods[blockColumn] = computeLod();
+			}
+			return lods[blockColumn];
+		}
+
+	private:
+		std::array<float, HiZBuffer::BlocksPerTileSide> lods{};
+		uint32_t valid = 0;
+		int32_t row = -1;
+	};
+
+	// Texels modulate the interpolated vertex color
+	inline Gadget::Color Modulate(const Gadget::Color& color, const Gadget::Color& texel)
+	{
+		return Gadget::Color(color.r * texel.r, color.g * texel.g, color.b * texel.b, color.a * texel.a);
+	}
+
+	inline void ApplyDebugCheckerboard(Gadget::Color& color)
+	{
+		if (static_cast<int>(std::floor(color.r * 8.0) + std::floor(color.g * 8.0)) % 2 == 0)
+		{
+			color = { 0, 0, 0, 255 };
+		}
+		else
+		{
+			color = { 255, 255, 255, 255 };
+		}
+	}
+}
@@ -1,31 +1,116 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstdint>
+#include <cstring>
 #include <print>
 #include <vector>
 
 namespace RS
 {
-	template <typename Pixel>
+	// Pixels stored row after row, the way window surfaces and image files expect them
+	struct LinearLayout
+	{
+		static constexpr bool IsLinear = true;
+		static constexpr uint16_t SpanWidth = uint16_t{ 1 } << 15; // Any power of two works, rows are contiguous all the way
+
+		static uint32_t PaddedSize(uint16_t size){ return size; }
+		static uint32_t GetIndex(uint16_t x, uint16_t y, uint32_t pitch){ return (static_cast<uint32_t>(y) * pitch) + x; }
+	};
+
+	// Pixels stored in Size x Size micro-tiles, each one contiguous and row-major, with the micro-tiles themselves in row-major order
+	// Tall and diagonal triangles touch far fewer cache lines and pages than with rows that are the whole target wide
+	template <uint16_t Size>
+	struct TiledLayout
+	{
+		static_assert(std::has_single_bit(Size), "Micro-tiles have to be a power of two across");
+
+		static constexpr bool IsLinear = false;
+		static constexpr uint16_t SpanWidth = Size;
+
+		// The micro-tiles along the right and bottom edges are always stored whole
+		static uint32_t PaddedSize(uint16_t size){ return (static_cast<uint32_t>(size) + Size - 1) & ~static_cast<uint32_t>(Size - 1); }
+
+		// pitch is the padded width
+		static uint32_t GetIndex(uint16_t x, uint16_t y, uint32_t pitch)
+		{
+			constexpr uint32_t Mask = Size - 1;
+			const uint32_t tileRow = (static_cast<uint32_t>(y) & ~Mask) * pitch;
+			const uint32_t tileColumn = (static_cast<uint32_t>(x) & ~Mask) * Size;
+			return tileRow + tileColumn + ((y & Mask) * Size) + (x & Mask);
+		}
+	};
+
+	// Layout of the frame buffer's color and depth targets, chosen at build time with RS_RENDER_TARGET_LAYOUT
+	// 8x8 micro-tiles line up with the Hi-Z blocks, and keep every SIMD kernel's lane block contiguous
+#if defined(RS_RENDER_TARGET_LAYOUT_TILED)
+	using FrameBufferLayout = TiledLayout<8>;
+#else
+	using FrameBufferLayout = LinearLayout;
+#endif
+
+	template <typename Pixel, typename Layout = LinearLayout>
 	class RenderTarget
 	{
 	public:
-		RenderTarget(uint16_t width_, uint16_t height_, Pixel default_) : width(width_), height(height_)
+		using PixelT = Pixel;
+		static constexpr bool IsLinear = Layout::IsLinear;
+
+		// Pixels [x, x + SpanWidth) of a row are contiguous in memory when x is a multiple of SpanWidth, as far as the end of the row
+		static constexpr uint16_t SpanWidth = Layout::SpanWidth;
+
+		RenderTarget(uint16_t width_, uint16_t height_, Pixel default_) : width(width_), height(height_), pitch(Layout::PaddedSize(width_))
 		{
-			pixels.resize(width * height, default_);
+			pixels.resize(static_cast<size_t>(pitch) * Layout::PaddedSize(height), default_);
 		}
 
 		void Clear(const Pixel& color)
 		{
-			for (auto& pixel : pixels)
+			if (pitch == Layout::PaddedSize(width))
+			{
+				Fill(Data(), static_cast<size_t>(pitch) * Layout::PaddedSize(height), color);
+				return;
+			}
+
+			for (uint16_t y = 0; y < height; y++)
+			{
+				Fill(GetSpan(0, y), width, color);
+			}
+		}
+
+		// Max values are exclusive
+		void ClearRect(uint16_t minX, uint16_t minY, uint16_t maxX, uint16_t maxY, const Pixel& color)
+		{
+			if constexpr (!IsLinear)
+			{
+				// Rects made of whole micro-tiles (like the frame buffer's tiles) are one contiguous run per row of micro-tiles
+				const auto isAligned = [](uint16_t min, uint16_t max, uint16_t limit){ return min < max && min % SpanWidth == 0 && (max % SpanWidth == 0 || max == limit); };
+				if (isAligned(minX, maxX, width) && isAligned(minY, maxY, height))
+				{
+					const size_t runLength = static_cast<size_t>(Layout::PaddedSize(maxX) - minX) * SpanWidth;
+					for (uint32_t y = minY; y < maxY; y += SpanWidth)
+					{
+						Fill(GetSpan(minX, static_cast<uint16_t>(y)), runLength, color);
+					}
+					return;
+				}
+			}
+
+			for (uint16_t y = minY; y < maxY; y++)
 			{
-				pixel = color;
+				for (uint32_t x = minX; x < maxX; x = NextSpan(x))
+				{
+					const auto end = std::min<uint32_t>(NextSpan(x), maxX);
+					Fill(GetSpan(static_cast<uint16_t>(x), y), end - x, color);
+				}
 			}
 		}
 
 		const Pixel& GetPixel(uint16_t x, uint16_t y) const
 		{
-			return pixels[GetPixelIndex(x, y)];
+			return Data()[GetPixelIndex(x, y)];
 		}
 
 		void SetPixel(uint16_t x, uint16_t y, const Pixel& color)
@@ -36,20 +121,85 @@ namespace RS
 				return;
 			}
 
-			pixels[GetPixelIndex(x, y)] = color;
+			Data()[GetPixelIndex(x, y)] = color;
 		}
 
 		uint32_t GetPixelIndex(uint16_t x, uint16_t y) const
 		{
-			return (static_cast<uint32_t>(y) * width) + x;
+			return Layout::GetIndex(x, y, pitch);
+		}
+
+		// Start of the contiguous run of pixels holding (x, y), see SpanWidth
+		Pixel* GetSpan(uint16_t x, uint16_t y){ return Data() + GetPixelIndex(x, y); }
+		const Pixel* GetSpan(uint16_t x, uint16_t y) const{ return Data() + GetPixelIndex(x, y); }
+
+		Pixel* GetRow(uint16_t y) requires IsLinear{ return GetSpan(0, y); }
+		const Pixel* GetRow(uint16_t y) const requires IsLinear{ return GetSpan(0, y); }
+
+		uint16_t Width() const{ return width; }
+		uint16_t Height() const{ return height; }
+
+		// Distance between the start of two rows, in pixels
+		uint32_t Pitch() const requires IsLinear{ return pitch; }
+
+		// Writes the pixels out row by row, de-swizzling in the same pass if the layout isn't linear
+		// destination must hold Height() rows of destinationPitch pixels each
+		void CopyTo(Pixel* destination, uint32_t destinationPitch) const
+		{
+			for (uint16_t y = 0; y < height; y++)
+			{
+				Pixel* row = destination + (static_cast<size_t>(y) * destinationPitch);
+				for (uint32_t x = 0; x < width; x = NextSpan(x))
+				{
+					const auto end = std::min<uint32_t>(NextSpan(x), width);
+					std::memcpy(row + x, GetSpan(static_cast<uint16_t>(x), y), (end - x) * sizeof(Pixel));
+				}
+			}
+		}
+
+		// Renders into memory owned by someone else (i.e. a window surface) until Detach is called
+		// The memory must hold Height() rows of pitch_ pixels each
+		void Attach(Pixel* memory, uint32_t pitch_) requires IsLinear
+		{
+			external = memory;
+			pitch = pitch_;
 		}
 
-		std::vector<Pixel>& GetPixels(){ return pixels; }
-		const std::vector<Pixel>& GetPixels() const{ return pixels; }
+		void Detach() requires IsLinear
+		{
+			external = nullptr;
+			pitch = width;
+		}
+
+		bool IsAttached() const{ return external != nullptr; }
 
 	private:
 		std::vector<Pixel> pixels;
+		Pixel* external = nullptr;
 		uint16_t width;
 		uint16_t height;
+		uint32_t pitch;
+
+		Pixel* Data(){ return external != nullptr ? external : pixels.data(); }
+		const Pixel* Data() const{ return external != nullptr ? external : pixels.data(); }
+
+		// Start of the span after the one holding x
+		static uint32_t NextSpan(uint32_t x){ return (x / SpanWidth + 1) * SpanWidth; }
+
+		// memset when every byte of the value is the same (black, cleared depth), otherwise a fill the compiler turns into wide stores
+		static void Fill(Pixel* destination, size_t count, const Pixel& value)
+		{
+			std::array<uint8_t, sizeof(Pixel)> bytes;
+			std::memcpy(bytes.data(), &value, sizeof(Pixel));
+
+			if (std::all_of(bytes.begin(), bytes.end(), [&bytes](uint8_t byte){ return byte == bytes[0]; }))
+			{
+				std::memset(destination, bytes[0], count * sizeof(Pixel));
+			}
+			else
+			{
+				std::fill_n(destination, count, value);
+			}
+		}
 	};
 }
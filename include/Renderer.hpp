@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include "ClipVertexBuffer.hpp"
+#include "CommandList.hpp"
+#include "DrawCall.hpp"
+#include "FrameBuffer.hpp"
+#include "JobSystem.hpp"
+#include "PipelineStatistics.hpp"
+#include "RasterKernels.hpp"
+#include "TileBinner.hpp"
+#include "Viewport.hpp"
+
+namespace RS
+{
+	class Renderer
+	{
+	public:
+		// numThreads includes the thread calling Draw, which helps out while waiting on jobs
+		explicit Renderer(uint32_t numThreads = std::thread::hardware_concurrency()) : jobSystem(numThreads){}
+
+		void Draw(const Viewport& viewport, FrameBuffer& frameBuffer, const DrawCall& drawCall);
+
+		// Renders every draw in the list in one pass, with a single barrier per pipeline stage for all of them
+		void Submit(const Viewport& viewport, FrameBuffer& frameBuffer, const CommandList& commands);
+
+		JobSystem& GetJobSystem(){ return jobSystem; }
+
+		// Pipeline statistics are only gathered while enabled, since counting pixels costs a little in the raster kernels
+		// They add up over every Draw and Submit until they're reset
+		void EnableStatistics(bool enable){ collectStatistics = enable; }
+		bool IsCollectingStatistics() const{ return collectStatistics; }
+		const PipelineStatistics& GetStatistics() const{ return statistics; }
+		void ResetStatistics(){ statistics = PipelineStatistics(); }
+
+	private:
+		static constexpr size_t VerticesPerJob = 1024;
+		static constexpr size_t TrianglesPerJob = 256;
+
+		// A range of vertices or triangles from a single draw's mesh
+		struct DrawRange
+		{
+			uint32_t draw;
+			size_t begin;
+			size_t end;
+		};
+
+		// Every thread counts into its own slot, so jobs never write to the same cache line
+		struct alignas(64) ThreadStatistics
+		{
+			PipelineStatistics value;
+		};
+
+		JobSystem jobSystem;
+		CommandList immediateCommands; // Wraps single draws passed to Draw
+
+		bool collectStatistics = false;
+		PipelineStatistics statistics;
+		std::vector<ThreadStatistics> threadStatistics; // Added to statistics at the end of every Submit
+
+		// Ranges index every visible instance's vertices or triangles back to back, so one range can span several small instances
+		struct DrawInstances
+		{
+			size_t vertexOffset = 0;		// Where the draw's vertices start in clipVertices
+			std::vector<uint32_t> visible;	// Instances that passed the bounds check
+			std::array<Raster::TileKernel, 2> kernels{};	// Picked once per draw, indexed by BinnedTriangle::isPerspective
+			TextureSampler sampler;
+		};
+
+		std::vector<uint32_t> executionOrder;
+		std::vector<DrawInstances> drawInstances;
+		std::vector<DrawRange> vertexRanges;
+		std::vector<DrawRange> triangleRanges;
+
+		ClipVertexBuffer clipVertices;
+		std::vector<std::vector<uint32_t>> survivors; // Triangles left after the cull stage, one list per range of up to TrianglesPerJob
+		TileBinner binner;
+		const Raster::TileKernelTable* tileKernels = &Raster::SelectTileKernels();
+
+		// Fills in executionOrder, drawInstances and the job ranges. Returns the number of vertices the vertex stage has to transform
+		size_t BuildRanges(const CommandList& commands);
+
+		// Appends triangles [begin, end) of a draw's visible instances, carrying on the last range if it ends at begin
+		void AddTriangleRange(uint32_t draw, size_t begin, size_t end);
+
+		// Slot the calling job counts into, or null if statistics are disabled
+		PipelineStatistics* GetThreadStatistics(){ return collectStatistics ? &threadStatistics[jobSystem.CurrentThreadIndex()].value : nullptr; }
+	};
+}
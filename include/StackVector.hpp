@@ -50,32 +50,37 @@ namespace RS
 
 		bool push_back(const T& value)
 		{
-			if (size >= Capacity)
+			if (count >= Capacity)
 			{
 				return false;
 			}
 			
-			internalArray[size] = value;
-			size++;
+			internalArray[count] = value;
+			count++;
 			return true;
 		}
 
 		bool push_back(T&& value)
 		{
-			if (size >= Capacity)
+			if (count >= Capacity)
 			{
 				return false;
 			}
 
-			GADGET_BASIC_ASSERT(size < Capacity);
-			internalArray[size] = std::move(value);
-			size++;
+			GADGET_BASIC_ASSERT(count < Capacity);
+			internalArray[count] = std::move(value);
+			count++;
 			return true;
 		}
 
 		// Intentional no-op so this can serve as a drop-in replacement for std::vector
 		void reserve(size_t /* capacity */){ return; }
 
+		void clear(){ count = 0; }
+
+		size_t size() const{ return count; }
+		bool empty() const{ return count == 0; }
+
 		const T& operator[](int64_t i) const
 		{
 			GADGET_BASIC_ASSERT(i < Capacity);
@@ -90,11 +95,11 @@ namespace RS
 
 		Iterator begin(){ return Iterator(*this, 0); }
 		ConstIterator begin() const{ return ConstIterator(*this, 0); }
-		Iterator end(){ return Iterator(*this, Capacity); }
-		ConstIterator end() const{ return ConstIterator(*this, Capacity); }
+		Iterator end(){ return Iterator(*this, static_cast<int64_t>(count)); }
+		ConstIterator end() const{ return ConstIterator(*this, static_cast<int64_t>(count)); }
 
 	private:
 		std::array<T, Capacity> internalArray;
-		size_t size = 0;
+		size_t count = 0;
 	};
 }
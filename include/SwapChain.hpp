@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <GCore/Graphics/Color.hpp>
+
+#include "FrameBuffer.hpp"
+#include "JobSystem.hpp"
+
+struct SDL_Surface;
+struct SDL_Window;
+
+namespace RS
+{
+	enum class PresentMode : uint8_t
+	{
+		Copy,		// Render into an owned frame buffer, then copy it to the window surface
+		Direct,		// Render straight into the window surface's memory. Falls back to Copy if the surface layout doesn't match, or the frame buffer is tiled
+		Pipelined	// Copy the previous frame to the window surface on a worker while the next one renders
+	};
+
+	// Owns the frame buffers that get rendered into and presented to the window
+	// Usage per frame is BeginFrame -> render into the returned frame buffer -> EndFrame
+	class SwapChain
+	{
+	public:
+		// bufferCount only matters for PresentMode::Pipelined, which needs at least 2
+		SwapChain(SDL_Window* window_, JobSystem& jobSystem_, uint16_t width, uint16_t height, PresentMode mode_, size_t bufferCount = 2);
+		~SwapChain();
+
+		SwapChain(const SwapChain&) = delete;
+		SwapChain& operator=(const SwapChain&) = delete;
+
+		// Must be called between frames, i.e. from OnWindowResized
+		void Resize(uint16_t width, uint16_t height);
+
+		FrameBuffer& BeginFrame();
+		void EndFrame();
+
+		PresentMode GetMode() const{ return mode; }
+
+		Gadget::Color backgroundColor = Gadget::Color(0.1f, 0.1f, 0.1f);
+
+	private:
+		SDL_Window* window;
+		JobSystem& jobSystem;
+		PresentMode mode;
+
+		std::vector<FrameBuffer> buffers;
+		size_t currentBuffer = 0;
+
+		// Direct mode
+		SDL_Surface* lockedSurface = nullptr;
+
+		// Pipelined mode
+		bool hasPendingFrame = false;
+		SDL_Surface* presentSurface = nullptr;
+		const FrameBuffer* presentSource = nullptr;
+		JobCounter presentCounter;
+		std::function<void()> presentJob;
+	};
+}
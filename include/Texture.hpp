@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <GCore/Graphics/Color.hpp>
+
+#include "PixelFormat.hpp"
+#include "RenderTarget.hpp"
+
+namespace RS
+{
+	enum class TextureFilter : uint8_t
+	{
+		Nearest,	// Closest texel in the closest mip
+		Bilinear,	// Four closest texels in the closest mip
+		Trilinear	// Bilinear in the two closest mips, blended by how far between them the LOD is
+	};
+
+	// Immutable RGBA8 texture with a full mip chain, sampled with repeat addressing
+	// Every mip is stored in 4x4 texel micro-tiles of 64 contiguous bytes, so a bilinear footprint and the texels
+	// of neighbouring pixels touch a handful of cache lines instead of one per texel row
+	// The storage isn't cache line aligned, so a micro-tile usually straddles two lines
+	class Texture
+	{
+	public:
+		using TexelT = PixelRGBA8;
+		using MipT = RenderTarget<TexelT, TiledLayout<4>>;
+
+		// texels is width x height, row by row. Mips are box filtered all the way down to 1x1
+		Texture(uint16_t width_, uint16_t height_, std::span<const TexelT> texels);
+
+		uint16_t Width() const{ return mips.front().Width(); }
+		uint16_t Height() const{ return mips.front().Height(); }
+		size_t NumMips() const{ return mips.size(); }
+		const MipT& GetMip(size_t level) const{ return mips[level]; }
+
+		// lod is log2 of how many texels one pixel covers, see Raster::TextureLod
+		Gadget::Color Sample(float u, float v, float lod, TextureFilter filter) const;
+
+	private:
+		std::vector<MipT> mips;
+
+		Gadget::Color SampleNearest(size_t level, float u, float v) const;
+		Gadget::Color SampleBilinear(size_t level, float u, float v) const;
+	};
+
+	// Texture and filter a draw samples with, handed to the raster kernels
+	struct TextureSampler
+	{
+		const Texture* texture = nullptr;
+		TextureFilter filter = TextureFilter::Trilinear;
+
+		Gadget::Color Sample(float u, float v, float lod) const{ return texture->Sample(u, v, lod, filter); }
+	};
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <GCore/Assert.hpp>
+#include <GCore/Graphics/Color.hpp>
+
+#include "Raster.hpp"
+
+namespace RS
+{
+	// Screen-space triangle produced by the geometry stage, ready to be rasterized
+	struct BinnedTriangle
+	{
+		std::array<Raster::EdgeFunction, 3> edges;	// Edge i is opposite vertex i
+		Raster::AttributePlane depth;				// NDC z, which is linear in screen space
+		std::array<Raster::AttributePlane, 4> color;	// Red, green, blue and alpha, divided by w if isPerspective
+		std::array<Raster::AttributePlane, 2> texCoord;	// U and v, divided by w if isPerspective. Only set up if the draw is textured
+		Raster::AttributePlane invW;				// 1 / w, only set up if isPerspective
+		bool isPerspective = false;					// Colors have to be divided by the interpolated 1 / w at every pixel
+		uint32_t minDepth = 0;						// Conservative range of the depth buffer values the triangle can produce
+		uint32_t maxDepth = 0;
+		uint32_t draw = 0;							// Index of the draw call in the command list
+
+		// Pixel bounds, clamped to the render target. Max values are exclusive
+		int32_t minX = 0;
+		int32_t minY = 0;
+		int32_t maxX = 0;
+		int32_t maxY = 0;
+	};
+
+	struct TileRect
+	{
+		int32_t minX;
+		int32_t minY;
+		int32_t maxX; // Exclusive
+		int32_t maxY; // Exclusive
+	};
+
+	// Sorts triangles into fixed-size screen tiles
+	// Every producer (geometry job) gets its own set of bins so that binning needs no locks,
+	// and a tile is later walked producer by producer so primitive order stays deterministic
+	// Producers remember which tiles they wrote to, so resetting and walking the bins only touches those
+	class TileBinner
+	{
+	public:
+		static constexpr int32_t TileSize = 64;
+
+		void Reset(uint16_t width_, uint16_t height_, size_t numProducers_)
+		{
+			width = width_;
+			height = height_;
+			tilesX = (width + TileSize - 1) / TileSize;
+			tilesY = (height + TileSize - 1) / TileSize;
+			numProducers = numProducers_;
+
+			if (producers.size() < numProducers)
+			{
+				producers.resize(numProducers);
+			}
+
+			for (size_t i = 0; i < numProducers; i++)
+			{
+				auto& producer = producers[i];
+				producer.triangles.clear();
+				for (const auto tile : producer.touchedTiles)
+				{
+					producer.tiles[tile].clear();
+				}
+				producer.touchedTiles.clear();
+				producer.tiles.resize(NumTiles());
+			}
+
+			tileProducers.resize(NumTiles());
+			for (auto& tile : tileProducers)
+			{
+				tile.clear();
+			}
+		}
+
+		void Add(size_t producer, const BinnedTriangle& tri)
+		{
+			GADGET_BASIC_ASSERT(producer < numProducers);
+			if (tri.maxX <= tri.minX || tri.maxY <= tri.minY)
+			{
+				return;
+			}
+
+			auto& bins = producers[producer];
+			const auto triIndex = static_cast<uint32_t>(bins.triangles.size());
+			bins.triangles.push_back(tri);
+
+			const int32_t tileMinX = tri.minX / TileSize;
+			const int32_t tileMinY = tri.minY / TileSize;
+			const int32_t tileMaxX = std::min((tri.maxX - 1) / TileSize, tilesX - 1);
+			const int32_t tileMaxY = std::min((tri.maxY - 1) / TileSize, tilesY - 1);
+
+			for (int32_t ty = tileMinY; ty <= tileMaxY; ty++)
+			{
+				for (int32_t tx = tileMinX; tx <= tileMaxX; tx++)
+				{
+					const auto tile = static_cast<uint32_t>((ty * tilesX) + tx);
+					if (bins.tiles[tile].empty())
+					{
+						bins.touchedTiles.push_back(tile);
+					}
+					bins.tiles[tile].push_back(triIndex);
+				}
+			}
+		}
+
+		// Has to be called once every producer is done adding, before any tile is walked
+		void Finish()
+		{
+			for (size_t i = 0; i < numProducers; i++)
+			{
+				for (const auto tile : producers[i].touchedTiles)
+				{
+					tileProducers[tile].push_back(static_cast<uint32_t>(i));
+				}
+			}
+		}
+
+		// Calls func for every triangle overlapping the tile, in submission order
+		template <typename Func>
+		void ForEachTriangle(size_t tile, Func&& func) const
+		{
+			for (const auto producer : tileProducers[tile])
+			{
+				const auto& bins = producers[producer];
+				for (const auto triIndex : bins.tiles[tile])
+				{
+					func(bins.triangles[triIndex]);
+				}
+			}
+		}
+
+		TileRect GetTileRect(size_t tile) const
+		{
+			const auto tx = static_cast<int32_t>(tile % tilesX);
+			const auto ty = static_cast<int32_t>(tile / tilesX);
+
+			return TileRect{
+				tx * TileSize,
+				ty * TileSize,
+				std::min<int32_t>((tx + 1) * TileSize, width),
+				std::min<int32_t>((ty + 1) * TileSize, height)
+			};
+		}
+
+		size_t NumTiles() const{ return static_cast<size_t>(tilesX) * tilesY; }
+
+	private:
+		struct ProducerBins
+		{
+			std::vector<BinnedTriangle> triangles;
+			std::vector<std::vector<uint32_t>> tiles;
+			std::vector<uint32_t> touchedTiles; // Tiles with a non-empty bin, in the order they were first written
+		};
+
+		std::vector<ProducerBins> producers;
+		std::vector<std::vector<uint32_t>> tileProducers; // Producers that wrote to each tile, in producer order
+		size_t numProducers = 0;
+		int32_t width = 0;
+		int32_t height = 0;
+		int32_t tilesX = 0;
+		int32_t tilesY = 0;
+	};
+}
@@ -2,6 +2,8 @@
 
 #include <GCore/Math/Math.hpp>
 
+#include "ClipPosition.hpp"
+
 namespace RS
 {
 	class Viewport
@@ -9,11 +11,13 @@ namespace RS
 	public:
 		constexpr Viewport(int32_t xMin_, int32_t xMax_, int32_t yMin_, int32_t yMax_) : xMin(xMin_), xMax(xMax_), yMin(yMin_), yMax(yMax_){}
 
-		[[nodiscard]] inline constexpr Gadget::Vector2 NdcToViewport(const Gadget::Vector4& ndcPos) const
+		// Computed in the pipeline's precision, so float pipelines snap exactly what they'd compute in float
+		[[nodiscard]] inline constexpr Gadget::Vector2 NdcToViewport(const ClipPosition& ndcPos) const
 		{
+			const Real half = 0.5;
 			return Gadget::Vector2(
-				xMin + (xMax - xMin) * (0.5 + 0.5 * ndcPos.x),
-				yMin + (yMax - yMin) * (0.5 - 0.5 * ndcPos.y)
+				xMin + (xMax - xMin) * (half + half * ndcPos.x),
+				yMin + (yMax - yMin) * (half - half * ndcPos.y)
 			);
 		}
 
@@ -0,0 +1,78 @@
+#include "CommandList.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace RS;
+
+enum class DepthOrder : uint8_t
+{
+	Fixed,		// Has to stay in submission order
+	NearLow,	// Less, smaller depth wins
+	NearHigh	// Greater, larger depth wins
+};
+
+static DepthOrder GetDepthOrder(const DrawCall& drawCall)
+{
+	if (!drawCall.writeDepth || !drawCall.writeColor)
+	{
+		return DepthOrder::Fixed;
+	}
+
+	switch (drawCall.depthMode)
+	{
+		case DepthTestMode::Less:
+			return DepthOrder::NearLow;
+		case DepthTestMode::Greater:
+			return DepthOrder::NearHigh;
+		default:
+			return DepthOrder::Fixed;
+	}
+}
+
+// Clip space z of the object's origin. Grows with distance for regular projections, shrinks for reversed ones
+static double GetSortDepth(const DrawCall& drawCall)
+{
+	return (drawCall.transform * Gadget::Vector4(0.0, 0.0, 0.0, 1.0)).z;
+}
+
+void CommandList::BuildExecutionOrder(std::vector<uint32_t>& outOrder) const
+{
+	outOrder.resize(drawCalls.size());
+	std::iota(outOrder.begin(), outOrder.end(), 0);
+	if (!reorderForDepth)
+	{
+		return;
+	}
+
+	size_t runBegin = 0;
+	while (runBegin < drawCalls.size())
+	{
+		const auto order = GetDepthOrder(drawCalls[runBegin]);
+
+		size_t runEnd = runBegin + 1;
+		while (order != DepthOrder::Fixed && runEnd < drawCalls.size() && GetDepthOrder(drawCalls[runEnd]) == order)
+		{
+			runEnd++;
+		}
+
+		if (runEnd - runBegin > 1)
+		{
+			std::stable_sort(outOrder.begin() + runBegin, outOrder.begin() + runEnd, [&](uint32_t a, uint32_t b)
+			{
+				const auto& drawA = drawCalls[a];
+				const auto& drawB = drawCalls[b];
+				if (drawA.mode != drawB.mode)
+				{
+					return drawA.mode < drawB.mode;
+				}
+
+				const double depthA = GetSortDepth(drawA);
+				const double depthB = GetSortDepth(drawB);
+				return order == DepthOrder::NearLow ? depthA < depthB : depthA > depthB;
+			});
+		}
+
+		runBegin = runEnd;
+	}
+}
@@ -0,0 +1,158 @@
+#include "Culling.hpp"
+
+#include <cmath>
+
+#include "Raster.hpp"
+
+using namespace RS;
+
+template <CullMode Mode>
+static void CullTrianglesFor(const ClipVertexBuffer& vertices, const MeshView& mesh, size_t vertexOffset, size_t begin, size_t end, size_t triangleBase, std::vector<uint32_t>& survivors)
+{
+	const auto& indices = mesh.indices;
+	const auto* xs = vertices.snappedX.data();
+	const auto* ys = vertices.snappedY.data();
+	const auto* w = vertices.w.data();
+	const auto* outcodes = vertices.outcodes.data();
+
+	for (size_t t = begin; t < end; t++)
+	{
+		const size_t i0 = vertexOffset + indices[(t * 3)];
+		const size_t i1 = vertexOffset + indices[(t * 3) + 1];
+		const size_t i2 = vertexOffset + indices[(t * 3) + 2];
+
+		if (i0 == i1 || i1 == i2 || i2 == i0)
+		{
+			continue; // Degenerate, repeats a vertex
+		}
+
+		if (Raster::IsTriviallyRejected(outcodes[i0], outcodes[i1], outcodes[i2]))
+		{
+			continue; // Every vertex is outside the same frustum plane
+		}
+
+		// Triangles that need clipping have their orientation checked by triangle setup instead
+		const bool unclipped = Raster::IsTriviallyAccepted(outcodes[i0], outcodes[i1], outcodes[i2]) && w[i0] > 0.0 && w[i1] > 0.0 && w[i2] > 0.0;
+		if (unclipped)
+		{
+			// Same snapped positions and area as triangle setup, so both always agree on what gets culled
+			const int64_t area = ((xs[i1] - xs[i0]) * (ys[i2] - ys[i0])) - ((ys[i1] - ys[i0]) * (xs[i2] - xs[i0]));
+			if (area == 0)
+			{
+				continue; // Zero area
+			}
+
+			if constexpr (Mode == CullMode::CW)
+			{
+				if (area < 0)
+				{
+					continue; // Back-facing
+				}
+			}
+			else if constexpr (Mode == CullMode::CCW)
+			{
+				if (area > 0)
+				{
+					continue; // Back-facing
+				}
+			}
+		}
+
+		survivors.push_back(static_cast<uint32_t>(triangleBase + t));
+	}
+}
+
+void Raster::CullTriangles(const ClipVertexBuffer& vertices, const MeshView& mesh, size_t vertexOffset, size_t begin, size_t end, CullMode mode, size_t triangleBase, std::vector<uint32_t>& survivors)
+{
+	switch (mode)
+	{
+		case CullMode::None:
+			CullTrianglesFor<CullMode::None>(vertices, mesh, vertexOffset, begin, end, triangleBase, survivors);
+			break;
+		case CullMode::CW:
+			CullTrianglesFor<CullMode::CW>(vertices, mesh, vertexOffset, begin, end, triangleBase, survivors);
+			break;
+		case CullMode::CCW:
+			CullTrianglesFor<CullMode::CCW>(vertices, mesh, vertexOffset, begin, end, triangleBase, survivors);
+			break;
+	}
+}
+
+static double Determinant(double a, double b, double c, double d, double e, double f, double g, double h, double i)
+{
+	return (a * ((e * i) - (f * h))) - (b * ((d * i) - (f * g))) + (c * ((d * h) - (e * g)));
+}
+
+// Vector orthogonal to all three, the 4D equivalent of a cross product
+static Gadget::Vector4 Cross(const Gadget::Vector4& a, const Gadget::Vector4& b, const Gadget::Vector4& c)
+{
+	return Gadget::Vector4(
+		Determinant(a.y, a.z, a.w, b.y, b.z, b.w, c.y, c.z, c.w),
+		-Determinant(a.x, a.z, a.w, b.x, b.z, b.w, c.x, c.z, c.w),
+		Determinant(a.x, a.y, a.w, b.x, b.y, b.w, c.x, c.y, c.w),
+		-Determinant(a.x, a.y, a.z, b.x, b.y, b.z, c.x, c.y, c.z)
+	);
+}
+
+static double Length3(const Gadget::Vector4& v)
+{
+	return std::sqrt((v.x * v.x) + (v.y * v.y) + (v.z * v.z));
+}
+
+Raster::MeshletCuller::MeshletCuller(const Gadget::Matrix4& transform, CullMode mode_) : mode(mode_)
+{
+	// Transforming the basis vectors gives the columns, the planes need the rows
+	const std::array<Gadget::Vector4, 4> columns = {
+		transform * Gadget::Vector4(1.0, 0.0, 0.0, 0.0),
+		transform * Gadget::Vector4(0.0, 1.0, 0.0, 0.0),
+		transform * Gadget::Vector4(0.0, 0.0, 1.0, 0.0),
+		transform * Gadget::Vector4(0.0, 0.0, 0.0, 1.0)
+	};
+
+	const auto x = Gadget::Vector4(columns[0].x, columns[1].x, columns[2].x, columns[3].x);
+	const auto y = Gadget::Vector4(columns[0].y, columns[1].y, columns[2].y, columns[3].y);
+	const auto z = Gadget::Vector4(columns[0].z, columns[1].z, columns[2].z, columns[3].z);
+	const auto w = Gadget::Vector4(columns[0].w, columns[1].w, columns[2].w, columns[3].w);
+
+	// Same planes as ComputeOutcode's frustum outcodes
+	planes = { w + x, w - x, w + y, w - y, w + z, w - z };
+
+	// The one point that lands on clip space x = y = w = 0, whatever the projection
+	eye = Cross(x, y, w);
+}
+
+bool Raster::MeshletCuller::IsVisible(const Meshlet& meshlet) const
+{
+	for (const auto& plane : planes)
+	{
+		if (Gadget::Vector4::Dot(plane, meshlet.center) < -meshlet.radius * Length3(plane))
+		{
+			return false;
+		}
+	}
+
+	if (mode == CullMode::None || !meshlet.HasCone())
+	{
+		return true;
+	}
+
+	// Triangle setup's area has the opposite sign of Dot((n, -Dot(n, v)), eye) for any point v on a triangle with normal n
+	// Scaled by |eye.w|, offset is the direction from the eye to the meshlet's center (or to the eye, if eye.w is negative)
+	const auto& center = meshlet.center;
+	const auto offset = Gadget::Vector4((eye.w * center.x) - eye.x, (eye.w * center.y) - eye.y, (eye.w * center.z) - eye.z, 0.0);
+	const double threshold = (meshlet.coneCutoff * Length3(offset)) + (meshlet.radius * std::abs(eye.w));
+	const double along = Gadget::Vector4::Dot(offset, meshlet.coneAxis);
+
+	// Every triangle has a positive area if along passes the threshold, and a negative one if -along does
+	if (along >= threshold)
+	{
+		return mode != CullMode::CCW;
+	}
+
+	if (-along >= threshold)
+	{
+		return mode != CullMode::CW;
+	}
+
+	return true;
+}
@@ -0,0 +1,93 @@
+#include "FrameBuffer.hpp"
+
+#include <algorithm>
+
+#include "Profiler.hpp"
+
+using namespace RS;
+
+FrameBuffer::FrameBuffer(uint16_t width_, uint16_t height_) :
+	color(width_, height_, PackColor<ColorT>(Gadget::Color(0.0, 0.0, 0.0))),
+	depth(width_, height_, std::numeric_limits<DepthT>::max()),
+	hiZ(width_, height_, std::numeric_limits<DepthT>::max()),
+	width(width_),
+	height(height_),
+	tilesX((width_ + TileBinner::TileSize - 1) / TileBinner::TileSize)
+{
+	const int32_t tilesY = (height_ + TileBinner::TileSize - 1) / TileBinner::TileSize;
+	pendingClears.resize(static_cast<size_t>(tilesX) * tilesY, 0);
+}
+
+void FrameBuffer::Clear(const Gadget::Color& color_, DepthT depth_)
+{
+	RS_PROFILE_SCOPE(ProfileStage::Clear);
+
+	clearColor = PackColor<ColorT>(color_);
+	clearDepth = depth_;
+	std::fill(pendingClears.begin(), pendingClears.end(), static_cast<uint8_t>(PendingColor | PendingDepth));
+
+	// Only a fraction of the size of the depth buffer, not worth deferring
+	hiZ.Clear(depth_);
+}
+
+void FrameBuffer::ResolveColor()
+{
+	RS_PROFILE_SCOPE(ProfileStage::Clear);
+
+	const bool allPending = std::all_of(pendingClears.begin(), pendingClears.end(), [](uint8_t pending){ return (pending & PendingColor) != 0; });
+	if (allPending)
+	{
+		// Nothing was drawn, one big fill beats going tile by tile
+		color.Clear(clearColor);
+		for (auto& pending : pendingClears)
+		{
+			pending &= ~PendingColor;
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < pendingClears.size(); i++)
+	{
+		if ((pendingClears[i] & PendingColor) != 0)
+		{
+			const auto tile = GetTileRect(i);
+			color.ClearRect(static_cast<uint16_t>(tile.minX), static_cast<uint16_t>(tile.minY), static_cast<uint16_t>(tile.maxX), static_cast<uint16_t>(tile.maxY), clearColor);
+			pendingClears[i] &= ~PendingColor;
+		}
+	}
+}
+
+TileRect FrameBuffer::GetTileRect(size_t tile) const
+{
+	const auto tx = static_cast<int32_t>(tile % tilesX);
+	const auto ty = static_cast<int32_t>(tile / tilesX);
+
+	return TileRect{
+		tx * TileBinner::TileSize,
+		ty * TileBinner::TileSize,
+		std::min<int32_t>((tx + 1) * TileBinner::TileSize, width),
+		std::min<int32_t>((ty + 1) * TileBinner::TileSize, height)
+	};
+}
+
+void FrameBuffer::ApplyPendingClear(const TileRect& tile, uint8_t& pending)
+{
+	RS_PROFILE_SCOPE(ProfileStage::Clear);
+
+	const auto minX = static_cast<uint16_t>(tile.minX);
+	const auto minY = static_cast<uint16_t>(tile.minY);
+	const auto maxX = static_cast<uint16_t>(tile.maxX);
+	const auto maxY = static_cast<uint16_t>(tile.maxY);
+
+	if ((pending & PendingColor) != 0)
+	{
+		color.ClearRect(minX, minY, maxX, maxY, clearColor);
+	}
+
+	if ((pending & PendingDepth) != 0)
+	{
+		depth.ClearRect(minX, minY, maxX, maxY, clearDepth);
+	}
+
+	pending = 0;
+}
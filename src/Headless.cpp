@@ -0,0 +1,126 @@
+#include "Headless.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <print>
+
+#include <GCore/Graphics/MeshData.hpp>
+#include <GCore/Math/Math.hpp>
+
+#include "DrawCall.hpp"
+#include "FrameBuffer.hpp"
+#include "ImageWriter.hpp"
+#include "MeshAssets.hpp"
+#include "MeshCache.hpp"
+#include "Profiler.hpp"
+#include "RasterKernels.hpp"
+#include "Renderer.hpp"
+#include "Viewport.hpp"
+
+using namespace RS;
+
+static constexpr double FrameTime = 1.0 / 60.0;
+
+static std::string GetCapturePath(const std::string& pattern, uint32_t frame)
+{
+	auto path = pattern;
+	if (const auto index = path.find("{}"); index != std::string::npos)
+	{
+		path.replace(index, 2, std::to_string(frame));
+	}
+
+	return path;
+}
+
+int RS::RunHeadless(const HeadlessOptions& options)
+{
+	CachedModel model;
+	Gadget::MeshData builtInMesh;
+	MeshView mesh;
+	switch (options.scene)
+	{
+		case Scene::Teapot:
+			model = LoadCachedModel("assets/teapot.stl");
+			if (model.IsEmpty())
+			{
+				std::println("Could not load the teapot model");
+				return 1;
+			}
+			mesh = model.Meshes()[0];
+			break;
+		case Scene::Cube:
+			builtInMesh = GetCubeMesh();
+			mesh = builtInMesh;
+			break;
+		case Scene::Rect:
+			builtInMesh = GetRectMesh();
+			mesh = builtInMesh;
+			break;
+	}
+
+	Renderer renderer;
+	renderer.EnableStatistics(options.printStatistics);
+	FrameBuffer frameBuffer(options.width, options.height);
+	const auto viewport = Viewport(0, options.width, 0, options.height);
+	const auto aspect = options.width * 1.0 / options.height;
+
+	const auto pos = Gadget::Vector3(0.0, 0.0, -10.0);
+	auto rot = Gadget::Euler(0.0, 0.0, 0.0);
+	const auto scale = Gadget::Vector3(0.5, 0.5, 0.5);
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(options.numFrames);
+
+	for (uint32_t frame = 0; frame < options.numFrames; frame++)
+	{
+		RS_PROFILE_BEGIN_FRAME();
+		RS_PROFILE_SCOPE(ProfileStage::Frame);
+
+		rot = rot + Gadget::Euler(FrameTime * 25.0 * 1.5, FrameTime * 25.0, 0.0);
+
+		const auto positionMatrix = Gadget::Math::Translate(pos);
+		const auto rotationMatrix = Gadget::Math::ToMatrix4(Gadget::Math::ToQuaternion(rot));
+		const auto scaleMatrix = Gadget::Math::Scale(scale);
+		const auto transform = Gadget::Matrix4::Perspective(90.0, aspect, 0.01, 1000.0) * (positionMatrix * (rotationMatrix * scaleMatrix));
+
+		const auto start = std::chrono::steady_clock::now();
+		frameBuffer.Clear();
+		renderer.Draw(viewport, frameBuffer, DrawCall(mesh, transform));
+		frameBuffer.ResolveColor();
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+		const bool isCaptured = std::ranges::find(options.captureFrames, frame) != options.captureFrames.end();
+		if (isCaptured && !options.outputPath.empty())
+		{
+			const auto path = GetCapturePath(options.outputPath, frame);
+			if (WriteImage(path, frameBuffer))
+			{
+				std::println("Wrote frame {} to {}", frame, path);
+			}
+		}
+	}
+
+	if (frameTimes.empty())
+	{
+		return 0;
+	}
+
+	const double total = std::reduce(frameTimes.begin(), frameTimes.end(), 0.0);
+	const double average = total / static_cast<double>(frameTimes.size());
+	std::ranges::sort(frameTimes);
+
+	std::println("Rendered {} frames at {}x{} on {} threads with {} kernels", frameTimes.size(), options.width, options.height, renderer.GetJobSystem().NumThreads(), Raster::GetSelectedKernelName());
+	std::println("Total {:.3f}ms, average {:.3f}ms ({:.1f} fps), min {:.3f}ms, median {:.3f}ms, max {:.3f}ms",
+		total, average, 1'000.0 / average, frameTimes.front(), frameTimes[frameTimes.size() / 2], frameTimes.back());
+
+	if (options.printStatistics)
+	{
+		std::println("Pipeline statistics per frame:");
+		renderer.GetStatistics().ForEachCounter([&](const char* name, uint64_t value)
+		{
+			std::println("  {:<24}{:>14.1f}", name, static_cast<double>(value) / static_cast<double>(frameTimes.size()));
+		});
+	}
+	return 0;
+}
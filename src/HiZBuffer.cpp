@@ -0,0 +1,204 @@
+#include "HiZBuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+using namespace RS;
+
+static_assert(FrameBufferLayout::SpanWidth % HiZBuffer::BlockSize == 0, "Refresh reads each row of a block as one span");
+
+HiZBuffer::HiZBuffer(uint16_t width_, uint16_t height_, uint32_t depth) : tilesX((width_ + TileBinner::TileSize - 1) / TileBinner::TileSize)
+{
+	const int32_t tilesY = (height_ + TileBinner::TileSize - 1) / TileBinner::TileSize;
+	tiles.resize(static_cast<size_t>(tilesX) * tilesY);
+	Clear(depth);
+}
+
+struct BlockTest
+{
+	bool rejected = false;
+	bool accepted = false;
+};
+
+// Depth across the triangle never leaves [tri.minDepth, tri.maxDepth]
+static BlockTest TestBlock(DepthTestMode mode, const BinnedTriangle& tri, uint32_t blockMin, uint32_t blockMax)
+{
+	BlockTest test;
+	switch (mode)
+	{
+		case DepthTestMode::Less:
+			test.rejected = tri.minDepth >= blockMax;
+			test.accepted = tri.maxDepth < blockMin;
+			break;
+		case DepthTestMode::LessEqual:
+			test.rejected = tri.minDepth > blockMax;
+			test.accepted = tri.maxDepth <= blockMin;
+			break;
+		case DepthTestMode::Greater:
+			test.rejected = tri.maxDepth <= blockMin;
+			test.accepted = tri.minDepth > blockMax;
+			break;
+		case DepthTestMode::GreaterEqual:
+			test.rejected = tri.maxDepth < blockMin;
+			test.accepted = tri.minDepth >= blockMax;
+			break;
+		case DepthTestMode::Equal:
+			test.rejected = tri.maxDepth < blockMin || tri.minDepth > blockMax;
+			break;
+		case DepthTestMode::NotEqual:
+			test.accepted = tri.maxDepth < blockMin || tri.minDepth > blockMax;
+			break;
+		case DepthTestMode::Always:
+		case DepthTestMode::Never:
+			break;
+	}
+	return test;
+}
+
+// Whether exact bounds could reject the triangle, given bounds that may be wider than the depths in the block
+// Exact bounds lie inside the wide ones, so a triangle in front of the nearest wide bound stays visible either way
+static bool CouldReject(DepthTestMode mode, const BinnedTriangle& tri, uint32_t blockMin, uint32_t blockMax)
+{
+	switch (mode)
+	{
+		case DepthTestMode::Less:
+		case DepthTestMode::LessEqual:
+			return tri.minDepth >= blockMin;
+		case DepthTestMode::Greater:
+		case DepthTestMode::GreaterEqual:
+			return tri.maxDepth <= blockMax;
+		case DepthTestMode::Equal:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void HiZBuffer::Clear(uint32_t depth)
+{
+	for (auto& bounds : tiles)
+	{
+		bounds.minDepth.fill(depth);
+		bounds.maxDepth.fill(depth);
+		bounds.updates.fill(0);
+	}
+}
+
+BlockMask HiZBuffer::Classify(const TileRect& tile, const BinnedTriangle& tri, DepthTestMode mode, const RenderTarget<uint32_t, FrameBufferLayout>& depth, uint64_t overlapped)
+{
+	const int32_t minBlockX = (std::max(tri.minX, tile.minX) - tile.minX) / BlockSize;
+	const int32_t minBlockY = (std::max(tri.minY, tile.minY) - tile.minY) / BlockSize;
+	const int32_t maxBlockX = (std::min(tri.maxX, tile.maxX) - 1 - tile.minX) / BlockSize;
+	const int32_t maxBlockY = (std::min(tri.maxY, tile.maxY) - 1 - tile.minY) / BlockSize;
+
+	if (minBlockX > maxBlockX || minBlockY > maxBlockY || mode == DepthTestMode::Never)
+	{
+		return BlockMask{ 0, 0 };
+	}
+
+	// Blocks overlapped by the triangle's bounds
+	const uint64_t rowBlocks = ((uint64_t{ 1 } << (maxBlockX - minBlockX + 1)) - 1) << minBlockX;
+	uint64_t candidates = 0;
+	for (int32_t by = minBlockY; by <= maxBlockY; by++)
+	{
+		candidates |= rowBlocks << (by * BlocksPerTileSide);
+	}
+	candidates &= overlapped;
+
+	if (mode == DepthTestMode::Always)
+	{
+		return BlockMask{ candidates, candidates };
+	}
+
+	auto& bounds = tiles[GetTileIndex(tile)];
+	BlockMask result{ 0, 0 };
+	for (uint64_t remaining = candidates; remaining != 0; remaining &= remaining - 1)
+	{
+		const int block = std::countr_zero(remaining);
+		auto test = TestBlock(mode, tri, bounds.minDepth[block], bounds.maxDepth[block]);
+		if (!test.rejected && bounds.updates[block] >= UpdatesBeforeRefresh && CouldReject(mode, tri, bounds.minDepth[block], bounds.maxDepth[block]))
+		{
+			Refresh(tile, bounds, block, depth);
+			test = TestBlock(mode, tri, bounds.minDepth[block], bounds.maxDepth[block]);
+		}
+
+		const uint64_t bit = uint64_t{ 1 } << block;
+		if (!test.rejected)
+		{
+			result.visible |= bit;
+		}
+
+		if (test.accepted)
+		{
+			result.accepted |= bit;
+		}
+	}
+
+	return result;
+}
+
+void HiZBuffer::Update(const TileRect& tile, const BlockMask& blocks, const BinnedTriangle& tri, DepthTestMode mode)
+{
+	auto& bounds = tiles[GetTileIndex(tile)];
+	for (uint64_t remaining = blocks.visible; remaining != 0; remaining &= remaining - 1)
+	{
+		const int block = std::countr_zero(remaining);
+		const bool covered = ((blocks.covered >> block) & 1) != 0;
+		auto& blockMin = bounds.minDepth[block];
+		auto& blockMax = bounds.maxDepth[block];
+
+		// Every write is inside the triangle's depth range. A block the triangle covers is tested at every pixel,
+		// so passing depths can only move its far (or near) bound towards the triangle
+		switch (mode)
+		{
+			case DepthTestMode::Less:
+			case DepthTestMode::LessEqual:
+				blockMin = std::min(blockMin, tri.minDepth);
+				blockMax = covered ? std::min(blockMax, tri.maxDepth) : blockMax;
+				break;
+			case DepthTestMode::Greater:
+			case DepthTestMode::GreaterEqual:
+				blockMax = std::max(blockMax, tri.maxDepth);
+				blockMin = covered ? std::max(blockMin, tri.minDepth) : blockMin;
+				break;
+			case DepthTestMode::Always:
+				blockMin = covered ? tri.minDepth : std::min(blockMin, tri.minDepth);
+				blockMax = covered ? tri.maxDepth : std::max(blockMax, tri.maxDepth);
+				break;
+			case DepthTestMode::NotEqual:
+				blockMin = std::min(blockMin, tri.minDepth);
+				blockMax = std::max(blockMax, tri.maxDepth);
+				break;
+			case DepthTestMode::Equal:
+			case DepthTestMode::Never:
+				break; // Writes leave the depth as it was
+		}
+
+		bounds.updates[block] = static_cast<uint8_t>(std::min(bounds.updates[block] + 1, 255));
+	}
+}
+
+void HiZBuffer::Refresh(const TileRect& tile, TileBounds& bounds, int block, const RenderTarget<uint32_t, FrameBufferLayout>& depth) const
+{
+	const int32_t minX = tile.minX + ((block % BlocksPerTileSide) * BlockSize);
+	const int32_t minY = tile.minY + ((block / BlocksPerTileSide) * BlockSize);
+	const int32_t maxX = std::min(minX + BlockSize, tile.maxX);
+	const int32_t maxY = std::min(minY + BlockSize, tile.maxY);
+
+	uint32_t blockMin = std::numeric_limits<uint32_t>::max();
+	uint32_t blockMax = 0;
+	for (int32_t y = minY; y < maxY; y++)
+	{
+		const auto* span = depth.GetSpan(static_cast<uint16_t>(minX), static_cast<uint16_t>(y));
+		for (int32_t x = 0; x < maxX - minX; x++)
+		{
+			blockMin = std::min(blockMin, span[x]);
+			blockMax = std::max(blockMax, span[x]);
+		}
+	}
+
+	bounds.minDepth[block] = blockMin;
+	bounds.maxDepth[block] = blockMax;
+	bounds.updates[block] = 0;
+}
@@ -0,0 +1,183 @@
+#include "ImageWriter.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <print>
+#include <string_view>
+#include <vector>
+
+using namespace RS;
+
+static std::vector<uint8_t> GetRgbRow(const FrameBuffer& frameBuffer, uint16_t y)
+{
+	std::vector<uint8_t> row;
+	row.reserve(static_cast<size_t>(frameBuffer.Width()) * 3);
+
+	for (uint16_t x = 0; x < frameBuffer.Width(); x++)
+	{
+		const auto& pixel = frameBuffer.color.GetPixel(x, y);
+		row.push_back(pixel.r);
+		row.push_back(pixel.g);
+		row.push_back(pixel.b);
+	}
+
+	return row;
+}
+
+static bool OpenFile(const std::filesystem::path& path, std::ofstream& outFile)
+{
+	outFile.open(path, std::ios::binary | std::ios::trunc);
+	if (!outFile)
+	{
+		std::println("Could not open '{}' for writing", path.string());
+		return false;
+	}
+
+	return true;
+}
+
+bool RS::WriteImage(const std::filesystem::path& path, const FrameBuffer& frameBuffer)
+{
+	const auto extension = path.extension().string();
+	if (extension == ".png")
+	{
+		return WritePng(path, frameBuffer);
+	}
+	else if (extension == ".ppm")
+	{
+		return WritePpm(path, frameBuffer);
+	}
+
+	std::println("Unknown image format '{}', expected .png or .ppm", extension);
+	return false;
+}
+
+bool RS::WritePpm(const std::filesystem::path& path, const FrameBuffer& frameBuffer)
+{
+	std::ofstream file;
+	if (!OpenFile(path, file))
+	{
+		return false;
+	}
+
+	file << "P6\n" << frameBuffer.Width() << " " << frameBuffer.Height() << "\n255\n";
+	for (uint16_t y = 0; y < frameBuffer.Height(); y++)
+	{
+		const auto row = GetRgbRow(frameBuffer, y);
+		file.write(reinterpret_cast<const char*>(row.data()), static_cast<std::streamsize>(row.size()));
+	}
+
+	return file.good();
+}
+
+static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+	static const auto table = []()
+	{
+		std::array<uint32_t, 256> result{};
+		for (uint32_t i = 0; i < result.size(); i++)
+		{
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; bit++)
+			{
+				value = (value & 1) != 0 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+			}
+			result[i] = value;
+		}
+		return result;
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void AppendBigEndian(std::vector<uint8_t>& buffer, uint32_t value)
+{
+	buffer.push_back(static_cast<uint8_t>(value >> 24));
+	buffer.push_back(static_cast<uint8_t>(value >> 16));
+	buffer.push_back(static_cast<uint8_t>(value >> 8));
+	buffer.push_back(static_cast<uint8_t>(value));
+}
+
+static void WriteChunk(std::ofstream& file, std::string_view type, const std::vector<uint8_t>& data)
+{
+	std::vector<uint8_t> chunk;
+	chunk.reserve(data.size() + 12);
+	AppendBigEndian(chunk, static_cast<uint32_t>(data.size()));
+	chunk.insert(chunk.end(), type.begin(), type.end());
+	chunk.insert(chunk.end(), data.begin(), data.end());
+
+	// The CRC covers the type and the data, not the length
+	AppendBigEndian(chunk, Crc32(chunk.data() + 4, chunk.size() - 4));
+	file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+}
+
+bool RS::WritePng(const std::filesystem::path& path, const FrameBuffer& frameBuffer)
+{
+	std::ofstream file;
+	if (!OpenFile(path, file))
+	{
+		return false;
+	}
+
+	static constexpr std::array<uint8_t, 8> signature = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write(reinterpret_cast<const char*>(signature.data()), signature.size());
+
+	std::vector<uint8_t> header;
+	AppendBigEndian(header, frameBuffer.Width());
+	AppendBigEndian(header, frameBuffer.Height());
+	header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 bits per channel, RGB, deflate, default filtering, no interlacing
+	WriteChunk(file, "IHDR", header);
+
+	// Every scanline starts with its filter type, 0 = none
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((static_cast<size_t>(frameBuffer.Width()) * 3 + 1) * frameBuffer.Height());
+	for (uint16_t y = 0; y < frameBuffer.Height(); y++)
+	{
+		const auto row = GetRgbRow(frameBuffer, y);
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), row.begin(), row.end());
+	}
+
+	// zlib stream made of stored (uncompressed) deflate blocks
+	static constexpr size_t MaxStoredBlockSize = 65535;
+	std::vector<uint8_t> compressed = { 0x78, 0x01 };
+	compressed.reserve(scanlines.size() + ((scanlines.size() / MaxStoredBlockSize) + 1) * 5 + 6);
+
+	size_t offset = 0;
+	do
+	{
+		const size_t blockSize = std::min(MaxStoredBlockSize, scanlines.size() - offset);
+		const bool isLast = offset + blockSize == scanlines.size();
+		const auto length = static_cast<uint16_t>(blockSize);
+		const auto inverseLength = static_cast<uint16_t>(~length);
+
+		compressed.push_back(isLast ? 1 : 0);
+		compressed.push_back(static_cast<uint8_t>(length));
+		compressed.push_back(static_cast<uint8_t>(length >> 8));
+		compressed.push_back(static_cast<uint8_t>(inverseLength));
+		compressed.push_back(static_cast<uint8_t>(inverseLength >> 8));
+		compressed.insert(compressed.end(), scanlines.begin() + static_cast<ptrdiff_t>(offset), scanlines.begin() + static_cast<ptrdiff_t>(offset + blockSize));
+		offset += blockSize;
+	} while (offset < scanlines.size());
+
+	uint32_t adlerA = 1;
+	uint32_t adlerB = 0;
+	for (const auto byte : scanlines)
+	{
+		adlerA = (adlerA + byte) % 65521;
+		adlerB = (adlerB + adlerA) % 65521;
+	}
+	AppendBigEndian(compressed, (adlerB << 16) | adlerA);
+
+	WriteChunk(file, "IDAT", compressed);
+	WriteChunk(file, "IEND", {});
+
+	return file.good();
+}
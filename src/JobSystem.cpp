@@ -0,0 +1,175 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "Profiler.hpp"
+
+using namespace RS;
+
+// Set on worker threads only. The index is only valid in the JobSystem the worker belongs to
+static thread_local const JobSystem* currentJobSystem = nullptr;
+static thread_local size_t currentQueueIndex = 0;
+
+size_t JobSystem::GetQueueIndex() const
+{
+	if (currentJobSystem == this)
+	{
+		return currentQueueIndex;
+	}
+
+	return std::this_thread::get_id() == ownerThread ? 0 : queues.size() - 1;
+}
+
+void JobSystem::WorkQueue::Push(const Job& job)
+{
+	auto lock = std::lock_guard(mutex);
+	jobs.push_back(job);
+}
+
+bool JobSystem::WorkQueue::Pop(Job& outJob)
+{
+	auto lock = std::lock_guard(mutex);
+	if (jobs.empty())
+	{
+		return false;
+	}
+
+	outJob = jobs.back();
+	jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::WorkQueue::Steal(Job& outJob)
+{
+	auto lock = std::lock_guard(mutex);
+	if (jobs.empty())
+	{
+		return false;
+	}
+
+	outJob = jobs.front();
+	jobs.pop_front();
+	return true;
+}
+
+JobSystem::JobSystem(uint32_t numThreads) : queues(std::max(numThreads, 1u) + 1)
+{
+	workers.reserve(queues.size() - 2);
+	for (size_t i = 1; i < queues.size() - 1; i++)
+	{
+		workers.emplace_back([this, i](){ WorkerLoop(i); });
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		auto lock = std::lock_guard(sleepMutex);
+		isRunning.store(false);
+	}
+	sleepCondition.notify_all();
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void JobSystem::Dispatch(size_t count, size_t rangeSize, JobFunction function, const void* context, JobCounter& counter, size_t queueOffset)
+{
+	rangeSize = std::max<size_t>(rangeSize, 1);
+	const size_t numJobs = (count + rangeSize - 1) / rangeSize;
+	if (numJobs == 0)
+	{
+		return;
+	}
+
+	counter.value.fetch_add(static_cast<int64_t>(numJobs), std::memory_order_relaxed);
+
+	// Spread the jobs over every queue up front so workers don't all have to steal from the same one
+	const size_t queueIndex = GetQueueIndex();
+	for (size_t i = 0; i < numJobs; i++)
+	{
+		const size_t begin = i * rangeSize;
+		const Job job{ function, context, begin, std::min(begin + rangeSize, count), &counter };
+		queues[(queueIndex + queueOffset + i) % queues.size()].Push(job);
+	}
+
+	queuedJobs.fetch_add(static_cast<int64_t>(numJobs), std::memory_order_release);
+
+	{
+		auto lock = std::lock_guard(sleepMutex);
+	}
+	sleepCondition.notify_all();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	const size_t queueIndex = GetQueueIndex();
+	while (!counter.IsDone())
+	{
+		if (TryRunJob(queueIndex))
+		{
+			continue;
+		}
+
+		// Nothing left to help with, sleep until some counter reaches zero
+		// Jobs signal through the JobSystem rather than the counter, since the counter can go out of scope as soon as it hits zero
+		const auto epoch = completionEpoch.load();
+		if (!counter.IsDone())
+		{
+			RS_PROFILE_SCOPE(ProfileStage::Idle);
+			completionEpoch.wait(epoch);
+		}
+	}
+}
+
+bool JobSystem::TryRunJob(size_t queueIndex)
+{
+	Job job;
+	bool foundJob = queues[queueIndex].Pop(job);
+
+	for (size_t i = 1; !foundJob && i < queues.size(); i++)
+	{
+		foundJob = queues[(queueIndex + i) % queues.size()].Steal(job);
+	}
+
+	if (!foundJob)
+	{
+		return false;
+	}
+
+	queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+	job.function(job.context, job.begin, job.end);
+
+	if (job.counter->value.fetch_sub(1) == 1)
+	{
+		completionEpoch.fetch_add(1);
+		completionEpoch.notify_all();
+	}
+
+	return true;
+}
+
+void JobSystem::WorkerLoop(size_t queueIndex)
+{
+	currentJobSystem = this;
+	currentQueueIndex = queueIndex;
+	RS_PROFILE_THREAD("Worker " + std::to_string(queueIndex));
+
+	while (isRunning.load(std::memory_order_acquire))
+	{
+		if (TryRunJob(queueIndex))
+		{
+			continue;
+		}
+
+		RS_PROFILE_SCOPE(ProfileStage::Idle);
+		auto lock = std::unique_lock(sleepMutex);
+		sleepCondition.wait(lock, [this]()
+		{
+			return !isRunning.load(std::memory_order_acquire) || queuedJobs.load(std::memory_order_acquire) > 0;
+		});
+	}
+}
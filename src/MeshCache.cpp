@@ -0,0 +1,323 @@
+#include "MeshCache.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <print>
+#include <span>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <GCore/Graphics/MeshLoader.hpp>
+
+#include "MeshOptimizer.hpp"
+
+using namespace RS;
+
+// Layout of a cache file:
+// CacheHeader, a CacheMesh for every mesh, then each mesh's vertices, indices and meshlets, every array starting on a CacheAlignment boundary
+// Everything is written in the machine's native layout, the header records enough of it to reject files from a different build
+
+static constexpr uint32_t CacheMagic = 0x48534D52; // "RMSH"
+static constexpr uint32_t CacheVersion = 3;
+static constexpr uint64_t CacheAlignment = 64;
+
+static_assert(std::is_trivially_copyable_v<Gadget::Vertex>, "Vertices are mapped straight from the cache file");
+static_assert(std::is_trivially_copyable_v<Meshlet>, "Meshlets are mapped straight from the cache file");
+static_assert(std::is_trivially_copyable_v<MeshBounds>, "Bounds are copied straight from the cache file");
+
+struct CacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertexSize;
+	uint32_t indexSize;
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+	uint64_t sourceHash;
+	uint64_t meshCount;
+};
+
+struct CacheMesh
+{
+	uint64_t vertexOffset;
+	uint64_t vertexCount;
+	uint64_t indexOffset;
+	uint64_t indexCount;
+	uint64_t meshletOffset;
+	uint64_t meshletCount;
+	MeshBounds bounds;
+};
+
+static uint64_t AlignUp(uint64_t value)
+{
+	return (value + CacheAlignment - 1) & ~(CacheAlignment - 1);
+}
+
+// 64-bit FNV-1a
+static uint64_t HashFile(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		return 0;
+	}
+
+	uint64_t hash = 0xCBF29CE484222325;
+	std::vector<char> buffer(size_t{ 1 } << 16);
+	while (file)
+	{
+		file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		for (std::streamsize i = 0; i < file.gcount(); i++)
+		{
+			hash = (hash ^ static_cast<uint8_t>(buffer[static_cast<size_t>(i)])) * 0x100000001B3;
+		}
+	}
+
+	return hash;
+}
+
+static int64_t GetWriteTime(const std::filesystem::path& path)
+{
+	std::error_code error;
+	const auto time = std::filesystem::last_write_time(path, error);
+	return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+static CacheHeader MakeHeader(const std::filesystem::path& sourcePath, uint64_t meshCount)
+{
+	std::error_code error;
+	const auto sourceSize = std::filesystem::file_size(sourcePath, error);
+
+	return CacheHeader{
+		CacheMagic,
+		CacheVersion,
+		static_cast<uint32_t>(sizeof(Gadget::Vertex)),
+		static_cast<uint32_t>(sizeof(uint32_t)),
+		error ? 0 : static_cast<uint64_t>(sourceSize),
+		GetWriteTime(sourcePath),
+		0,
+		meshCount
+	};
+}
+
+// Renderer indexes vertices and triangles straight from these without bounds checks, so a corrupt cache must never get that far
+static bool IsMeshValid(std::span<const Gadget::Vertex> vertices, std::span<const uint32_t> indices, std::span<const Meshlet> meshlets)
+{
+	for (const uint32_t index : indices)
+	{
+		if (index >= vertices.size())
+		{
+			return false;
+		}
+	}
+
+	const uint64_t triangleCount = indices.size() / 3;
+	for (const auto& meshlet : meshlets)
+	{
+		if (static_cast<uint64_t>(meshlet.triangleOffset) + meshlet.triangleCount > triangleCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Checks that the mapped file is a complete cache of the current source, and sets up views into it
+static bool ReadCache(const MappedFile& file, const std::filesystem::path& sourcePath, std::vector<MeshView>& outMeshes)
+{
+	const auto data = file.Data();
+	if (data.size() < sizeof(CacheHeader))
+	{
+		return false;
+	}
+
+	CacheHeader header{};
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	const auto expected = MakeHeader(sourcePath, header.meshCount);
+	if (header.magic != CacheMagic || header.version != CacheVersion || header.vertexSize != expected.vertexSize || header.indexSize != expected.indexSize || header.sourceSize != expected.sourceSize)
+	{
+		return false;
+	}
+
+	// Cheap check first, the source only has to be hashed if it was touched since the cache was written
+	if (header.sourceWriteTime != expected.sourceWriteTime && header.sourceHash != HashFile(sourcePath))
+	{
+		return false;
+	}
+
+	const uint64_t tableEnd = sizeof(CacheHeader) + (header.meshCount * sizeof(CacheMesh));
+	if (header.meshCount > data.size() / sizeof(CacheMesh) || tableEnd > data.size())
+	{
+		return false;
+	}
+
+	outMeshes.clear();
+	outMeshes.reserve(header.meshCount);
+	for (uint64_t i = 0; i < header.meshCount; i++)
+	{
+		CacheMesh mesh{};
+		std::memcpy(&mesh, data.data() + sizeof(CacheHeader) + (i * sizeof(CacheMesh)), sizeof(mesh));
+
+		const bool verticesFit = mesh.vertexCount <= data.size() / sizeof(Gadget::Vertex) && mesh.vertexOffset <= data.size() - (mesh.vertexCount * sizeof(Gadget::Vertex));
+		const bool indicesFit = mesh.indexCount <= data.size() / sizeof(uint32_t) && mesh.indexOffset <= data.size() - (mesh.indexCount * sizeof(uint32_t));
+		const bool meshletsFit = mesh.meshletCount <= data.size() / sizeof(Meshlet) && mesh.meshletOffset <= data.size() - (mesh.meshletCount * sizeof(Meshlet));
+		if (!verticesFit || !indicesFit || !meshletsFit || mesh.vertexOffset % CacheAlignment != 0 || mesh.indexOffset % CacheAlignment != 0 || mesh.meshletOffset % CacheAlignment != 0)
+		{
+			return false;
+		}
+
+		const auto* vertices = reinterpret_cast<const Gadget::Vertex*>(data.data() + mesh.vertexOffset);
+		const auto* indices = reinterpret_cast<const uint32_t*>(data.data() + mesh.indexOffset);
+		const auto* meshlets = reinterpret_cast<const Meshlet*>(data.data() + mesh.meshletOffset);
+		if (!IsMeshValid(std::span(vertices, mesh.vertexCount), std::span(indices, mesh.indexCount), std::span(meshlets, mesh.meshletCount)))
+		{
+			return false;
+		}
+
+		outMeshes.emplace_back(std::span(vertices, mesh.vertexCount), std::span(indices, mesh.indexCount), std::span(meshlets, mesh.meshletCount), std::span<const TexCoord>(), mesh.bounds);
+	}
+
+	return true;
+}
+
+static void WritePadding(std::ofstream& file, uint64_t& offset)
+{
+	static constexpr std::array<char, CacheAlignment> zeros{};
+
+	const uint64_t aligned = AlignUp(offset);
+	file.write(zeros.data(), static_cast<std::streamsize>(aligned - offset));
+	offset = aligned;
+}
+
+// Written to a temporary file first and moved into place, so a crash never leaves a half written cache behind
+static bool WriteCache(const std::filesystem::path& cachePath, const std::filesystem::path& sourcePath, const std::vector<OptimizedMesh>& meshes)
+{
+	auto header = MakeHeader(sourcePath, meshes.size());
+	header.sourceHash = HashFile(sourcePath);
+
+	std::vector<CacheMesh> table;
+	table.reserve(meshes.size());
+
+	uint64_t offset = AlignUp(sizeof(CacheHeader) + (meshes.size() * sizeof(CacheMesh)));
+	for (const auto& [mesh, meshlets, bounds] : meshes)
+	{
+		CacheMesh entry{};
+		entry.bounds = bounds;
+		entry.vertexOffset = offset;
+		entry.vertexCount = mesh.vertices.size();
+		offset = AlignUp(offset + (mesh.vertices.size() * sizeof(Gadget::Vertex)));
+
+		entry.indexOffset = offset;
+		entry.indexCount = mesh.indices.size();
+		offset = AlignUp(offset + (mesh.indices.size() * sizeof(uint32_t)));
+
+		entry.meshletOffset = offset;
+		entry.meshletCount = meshlets.size();
+		offset = AlignUp(offset + (meshlets.size() * sizeof(Meshlet)));
+
+		table.push_back(entry);
+	}
+
+	auto tempPath = cachePath;
+	tempPath += ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			return false;
+		}
+
+		uint64_t written = 0;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(CacheMesh)));
+		written += sizeof(header) + (table.size() * sizeof(CacheMesh));
+		WritePadding(file, written);
+
+		for (const auto& [mesh, meshlets, bounds] : meshes)
+		{
+			file.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(mesh.vertices.size() * sizeof(Gadget::Vertex)));
+			written += mesh.vertices.size() * sizeof(Gadget::Vertex);
+			WritePadding(file, written);
+
+			file.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(uint32_t)));
+			written += mesh.indices.size() * sizeof(uint32_t);
+			WritePadding(file, written);
+
+			file.write(reinterpret_cast<const char*>(meshlets.data()), static_cast<std::streamsize>(meshlets.size() * sizeof(Meshlet)));
+			written += meshlets.size() * sizeof(Meshlet);
+			WritePadding(file, written);
+		}
+
+		if (!file)
+		{
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, cachePath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
+
+CachedModel RS::LoadCachedModel(const std::filesystem::path& sourcePath)
+{
+	auto cachePath = sourcePath;
+	cachePath += ".rsmesh";
+	return LoadCachedModel(sourcePath, cachePath);
+}
+
+CachedModel RS::LoadCachedModel(const std::filesystem::path& sourcePath, const std::filesystem::path& cachePath)
+{
+	CachedModel result;
+
+	if (result.file.Open(cachePath))
+	{
+		if (ReadCache(result.file, sourcePath, result.meshes))
+		{
+			return result;
+		}
+
+		result.file.Close();
+	}
+
+	auto model = Gadget::MeshLoader::LoadMeshFromFile(sourcePath.string());
+	if (model.meshes.empty())
+	{
+		return result;
+	}
+
+	// Optimizing is the slow part of a first load, which is exactly why its output is what gets cached
+	std::vector<OptimizedMesh> meshes;
+	meshes.reserve(model.meshes.size());
+	for (auto& mesh : model.meshes)
+	{
+		meshes.push_back(OptimizeMesh(std::move(mesh)));
+	}
+
+	if (WriteCache(cachePath, sourcePath, meshes) && result.file.Open(cachePath) && ReadCache(result.file, sourcePath, result.meshes))
+	{
+		return result;
+	}
+
+	std::println(stderr, "Could not write the mesh cache {}, using the imported mesh as is", cachePath.string());
+	result.file.Close();
+	result.fallback = std::move(meshes);
+	result.meshes.clear();
+	for (const auto& mesh : result.fallback)
+	{
+		result.meshes.push_back(mesh.View());
+	}
+	return result;
+}
@@ -0,0 +1,484 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+using namespace RS;
+
+static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+static_assert(std::is_trivially_copyable_v<Gadget::Vertex>, "Vertices are welded by comparing their bytes");
+
+static Gadget::Vector4 Cross(const Gadget::Vector4& a, const Gadget::Vector4& b)
+{
+	return Gadget::Vector4((a.y * b.z) - (a.z * b.y), (a.z * b.x) - (a.x * b.z), (a.x * b.y) - (a.y * b.x), 0.0);
+}
+
+// Dot product of the xyz parts only, so points (w = 1) and directions (w = 0) can be mixed
+static double Dot3(const Gadget::Vector4& a, const Gadget::Vector4& b)
+{
+	return (a.x * b.x) + (a.y * b.y) + (a.z * b.z);
+}
+
+static Gadget::Vector4 Direction(const Gadget::Vector4& from, const Gadget::Vector4& to)
+{
+	return Gadget::Vector4(to.x - from.x, to.y - from.y, to.z - from.z, 0.0);
+}
+
+static double Length(const Gadget::Vector4& direction)
+{
+	return std::sqrt(Dot3(direction, direction));
+}
+
+// 64-bit FNV-1a of the vertex's bytes
+static uint64_t HashVertex(const Gadget::Vertex& vertex)
+{
+	std::array<unsigned char, sizeof(Gadget::Vertex)> bytes{};
+	std::memcpy(bytes.data(), &vertex, sizeof(vertex));
+
+	uint64_t hash = 0xCBF29CE484222325;
+	for (const auto byte : bytes)
+	{
+		hash = (hash ^ byte) * 0x100000001B3;
+	}
+
+	return hash;
+}
+
+size_t RS::WeldVertices(Gadget::MeshData& mesh)
+{
+	const size_t numVertices = mesh.vertices.size();
+
+	// Open addressing table of indices into welded, never more than half full
+	const size_t tableSize = std::bit_ceil(std::max<size_t>(numVertices * 2, 16));
+	std::vector<uint32_t> table(tableSize, InvalidIndex);
+
+	std::vector<Gadget::Vertex> welded;
+	welded.reserve(numVertices);
+
+	std::vector<uint32_t> remap(numVertices);
+	for (size_t i = 0; i < numVertices; i++)
+	{
+		const auto& vertex = mesh.vertices[i];
+
+		size_t slot = HashVertex(vertex) & (tableSize - 1);
+		while (table[slot] != InvalidIndex && std::memcmp(&welded[table[slot]], &vertex, sizeof(vertex)) != 0)
+		{
+			slot = (slot + 1) & (tableSize - 1);
+		}
+
+		if (table[slot] == InvalidIndex)
+		{
+			table[slot] = static_cast<uint32_t>(welded.size());
+			welded.push_back(vertex);
+		}
+
+		remap[i] = table[slot];
+	}
+
+	for (auto& index : mesh.indices)
+	{
+		index = remap[index];
+	}
+
+	const size_t removed = numVertices - welded.size();
+	mesh.vertices = std::move(welded);
+	return removed;
+}
+
+// Scores from Forsyth's article. Vertices of the last triangle score a bit lower so the order doesn't keep turning back on itself,
+// and vertices with few triangles left score higher so lone triangles get picked up before they're left stranded
+static double VertexScore(int32_t cachePosition, uint32_t remainingTriangles, uint32_t cacheSize)
+{
+	if (remainingTriangles == 0)
+	{
+		return -1.0;
+	}
+
+	double score = 0.0;
+	if (cachePosition >= 0)
+	{
+		if (cachePosition < 3)
+		{
+			score = 0.75;
+		}
+		else
+		{
+			score = std::pow(1.0 - (static_cast<double>(cachePosition - 3) / static_cast<double>(cacheSize - 3)), 1.5);
+		}
+	}
+
+	return score + (2.0 / std::sqrt(static_cast<double>(remainingTriangles)));
+}
+
+void RS::OptimizeVertexCache(std::span<uint32_t> indices, size_t numVertices, uint32_t cacheSize)
+{
+	cacheSize = std::max(cacheSize, 4u);
+	const size_t numTriangles = indices.size() / 3;
+
+	// Triangles that still have to be emitted, per vertex. Vertex v's live triangles are adjacency[offsets[v], offsets[v] + remaining[v])
+	std::vector<uint32_t> remaining(numVertices, 0);
+	for (size_t i = 0; i < numTriangles * 3; i++)
+	{
+		remaining[indices[i]]++;
+	}
+
+	std::vector<uint32_t> offsets(numVertices + 1, 0);
+	for (size_t v = 0; v < numVertices; v++)
+	{
+		offsets[v + 1] = offsets[v] + remaining[v];
+	}
+
+	std::vector<uint32_t> adjacency(numTriangles * 3);
+	{
+		std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < numTriangles * 3; i++)
+		{
+			adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	std::vector<int32_t> cachePositions(numVertices, -1);
+	std::vector<double> vertexScores(numVertices);
+	for (size_t v = 0; v < numVertices; v++)
+	{
+		vertexScores[v] = VertexScore(-1, remaining[v], cacheSize);
+	}
+
+	const auto triangleScore = [&](size_t t)
+	{
+		return vertexScores[indices[(t * 3)]] + vertexScores[indices[(t * 3) + 1]] + vertexScores[indices[(t * 3) + 2]];
+	};
+
+	std::vector<bool> isEmitted(numTriangles, false);
+	size_t best = InvalidIndex;
+	double bestScore = -std::numeric_limits<double>::infinity();
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		if (const double score = triangleScore(t); score > bestScore)
+		{
+			best = t;
+			bestScore = score;
+		}
+	}
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> nextCache;
+	cache.reserve(cacheSize + 3);
+	nextCache.reserve(cacheSize + 3);
+
+	std::vector<uint32_t> output;
+	output.reserve(numTriangles * 3);
+
+	size_t scanCursor = 0;
+	for (size_t emitted = 0; emitted < numTriangles; emitted++)
+	{
+		// Nothing in the cache has triangles left, carry on from the first triangle that hasn't been emitted
+		if (best == InvalidIndex)
+		{
+			while (isEmitted[scanCursor])
+			{
+				scanCursor++;
+			}
+			best = scanCursor;
+		}
+
+		isEmitted[best] = true;
+		const std::array<uint32_t, 3> tri = { indices[(best * 3)], indices[(best * 3) + 1], indices[(best * 3) + 2] };
+		output.insert(output.end(), tri.begin(), tri.end());
+
+		for (const auto v : tri)
+		{
+			const auto begin = adjacency.begin() + offsets[v];
+			const auto end = begin + remaining[v];
+			std::iter_swap(std::find(begin, end, static_cast<uint32_t>(best)), end - 1);
+			remaining[v]--;
+		}
+
+		// The triangle's vertices move to the front of the cache, anything pushed past the end falls out
+		nextCache.clear();
+		for (const auto v : tri)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end())
+			{
+				nextCache.push_back(v);
+			}
+		}
+
+		for (const auto v : cache)
+		{
+			if (std::find(tri.begin(), tri.end(), v) == tri.end())
+			{
+				nextCache.push_back(v);
+			}
+		}
+
+		for (size_t i = 0; i < nextCache.size(); i++)
+		{
+			const auto v = nextCache[i];
+			cachePositions[v] = i < cacheSize ? static_cast<int32_t>(i) : -1;
+			vertexScores[v] = VertexScore(cachePositions[v], remaining[v], cacheSize);
+		}
+
+		// Only triangles of vertices whose score just changed can have changed, the best one of them goes next
+		best = InvalidIndex;
+		bestScore = -std::numeric_limits<double>::infinity();
+		for (const auto v : nextCache)
+		{
+			for (uint32_t i = offsets[v]; i < offsets[v] + remaining[v]; i++)
+			{
+				if (const double score = triangleScore(adjacency[i]); score > bestScore)
+				{
+					best = adjacency[i];
+					bestScore = score;
+				}
+			}
+		}
+
+		nextCache.resize(std::min<size_t>(nextCache.size(), cacheSize));
+		std::swap(cache, nextCache);
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void RS::OptimizeVertexFetch(Gadget::MeshData& mesh)
+{
+	std::vector<uint32_t> remap(mesh.vertices.size(), InvalidIndex);
+	std::vector<Gadget::Vertex> reordered;
+	reordered.reserve(mesh.vertices.size());
+
+	for (auto& index : mesh.indices)
+	{
+		if (remap[index] == InvalidIndex)
+		{
+			remap[index] = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(mesh.vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	mesh.vertices = std::move(reordered);
+}
+
+// Ritter's bounding sphere, and a normal cone around the average of the triangles' normals
+static void ComputeMeshletBounds(const Gadget::MeshData& mesh, std::span<const uint32_t> vertices, Meshlet& meshlet)
+{
+	const auto position = [&](uint32_t v){ return mesh.vertices[v].position; };
+
+	const auto farthestFrom = [&](const Gadget::Vector4& point)
+	{
+		uint32_t farthest = vertices[0];
+		double farthestDistance = -1.0;
+		for (const auto v : vertices)
+		{
+			if (const double distance = Length(Direction(point, position(v))); distance > farthestDistance)
+			{
+				farthest = v;
+				farthestDistance = distance;
+			}
+		}
+		return farthest;
+	};
+
+	const auto a = position(farthestFrom(position(vertices[0])));
+	const auto b = position(farthestFrom(a));
+
+	auto center = Gadget::Vector4((a.x + b.x) * 0.5, (a.y + b.y) * 0.5, (a.z + b.z) * 0.5, 1.0);
+	double radius = Length(Direction(a, b)) * 0.5;
+	for (const auto v : vertices)
+	{
+		const auto offset = Direction(center, position(v));
+		const double distance = Length(offset);
+		if (distance > radius)
+		{
+			// Grow just enough to reach the point, keeping the opposite side where it is
+			const double newRadius = (radius + distance) * 0.5;
+			const double shift = (newRadius - radius) / distance;
+			center = Gadget::Vector4(center.x + (offset.x * shift), center.y + (offset.y * shift), center.z + (offset.z * shift), 1.0);
+			radius = newRadius;
+		}
+	}
+
+	meshlet.center = center;
+	meshlet.radius = radius;
+
+	std::vector<Gadget::Vector4> normals;
+	normals.reserve(meshlet.triangleCount);
+	auto axis = Gadget::Vector4(0.0, 0.0, 0.0, 0.0);
+	for (size_t t = meshlet.triangleOffset; t < size_t{ meshlet.triangleOffset } + meshlet.triangleCount; t++)
+	{
+		const auto p0 = position(mesh.indices[(t * 3)]);
+		const auto normal = Cross(Direction(p0, position(mesh.indices[(t * 3) + 1])), Direction(p0, position(mesh.indices[(t * 3) + 2])));
+		const double length = Length(normal);
+		if (length > 0.0)
+		{
+			normals.push_back(normal / length);
+			axis = axis + normals.back();
+		}
+	}
+
+	meshlet.coneAxis = Gadget::Vector4(0.0, 0.0, 0.0, 0.0);
+	meshlet.coneCutoff = 2.0;
+
+	const double axisLength = Length(axis);
+	if (normals.empty() || axisLength <= 0.0)
+	{
+		return;
+	}
+
+	meshlet.coneAxis = axis / axisLength;
+
+	double minDot = 1.0;
+	for (const auto& normal : normals)
+	{
+		minDot = std::min(minDot, Dot3(meshlet.coneAxis, normal));
+	}
+
+	if (minDot > 0.0)
+	{
+		meshlet.coneCutoff = std::sqrt(std::max(1.0 - (minDot * minDot), 0.0));
+	}
+}
+
+std::vector<Meshlet> RS::BuildMeshlets(const Gadget::MeshData& mesh, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	maxVertices = std::max(maxVertices, 3u);
+	maxTriangles = std::max(maxTriangles, 1u);
+
+	std::vector<Meshlet> meshlets;
+	std::vector<uint32_t> lastMeshlet(mesh.vertices.size(), InvalidIndex); // Which meshlet last used each vertex
+	std::vector<uint32_t> meshletVertices;
+	meshletVertices.reserve(maxVertices);
+
+	Meshlet current;
+	const size_t numTriangles = mesh.indices.size() / 3;
+	for (size_t t = 0; t < numTriangles; t++)
+	{
+		const std::array<uint32_t, 3> tri = { mesh.indices[(t * 3)], mesh.indices[(t * 3) + 1], mesh.indices[(t * 3) + 2] };
+
+		const auto meshletIndex = static_cast<uint32_t>(meshlets.size());
+		size_t newVertices = 0;
+		for (size_t i = 0; i < tri.size(); i++)
+		{
+			const bool isRepeat = (i > 0 && tri[i] == tri[0]) || (i > 1 && tri[i] == tri[1]);
+			if (lastMeshlet[tri[i]] != meshletIndex && !isRepeat)
+			{
+				newVertices++;
+			}
+		}
+
+		if (current.triangleCount == maxTriangles || meshletVertices.size() + newVertices > maxVertices)
+		{
+			ComputeMeshletBounds(mesh, meshletVertices, current);
+			meshlets.push_back(current);
+
+			current = Meshlet();
+			current.triangleOffset = static_cast<uint32_t>(t);
+			meshletVertices.clear();
+		}
+
+		for (const auto v : tri)
+		{
+			if (lastMeshlet[v] != meshlets.size())
+			{
+				lastMeshlet[v] = static_cast<uint32_t>(meshlets.size());
+				meshletVertices.push_back(v);
+			}
+		}
+
+		current.triangleCount++;
+	}
+
+	if (current.triangleCount > 0)
+	{
+		ComputeMeshletBounds(mesh, meshletVertices, current);
+		meshlets.push_back(current);
+	}
+
+	return meshlets;
+}
+
+void RS::OptimizeOverdraw(Gadget::MeshData& mesh, std::vector<Meshlet>& meshlets)
+{
+	if (meshlets.size() < 2)
+	{
+		return;
+	}
+
+	// Area weighted centroid, and the signed volume to tell whether the normals point out of the mesh or into it
+	auto centroid = Gadget::Vector4(0.0, 0.0, 0.0, 0.0);
+	double totalArea = 0.0;
+	double volume = 0.0;
+	for (size_t t = 0; t < mesh.indices.size() / 3; t++)
+	{
+		const auto& p0 = mesh.vertices[mesh.indices[(t * 3)]].position;
+		const auto& p1 = mesh.vertices[mesh.indices[(t * 3) + 1]].position;
+		const auto& p2 = mesh.vertices[mesh.indices[(t * 3) + 2]].position;
+
+		const double area = Length(Cross(Direction(p0, p1), Direction(p0, p2)));
+		centroid = centroid + (area / 3.0) * Gadget::Vector4(p0.x + p1.x + p2.x, p0.y + p1.y + p2.y, p0.z + p1.z + p2.z, 0.0);
+		totalArea += area;
+		volume += Dot3(p0, Cross(p1, p2));
+	}
+
+	if (totalArea <= 0.0)
+	{
+		return;
+	}
+
+	centroid = centroid / totalArea;
+	const double outward = volume < 0.0 ? -1.0 : 1.0;
+
+	std::vector<std::pair<double, uint32_t>> order;
+	order.reserve(meshlets.size());
+	for (size_t i = 0; i < meshlets.size(); i++)
+	{
+		const auto& meshlet = meshlets[i];
+		order.emplace_back(outward * Dot3(Direction(centroid, meshlet.center), meshlet.coneAxis), static_cast<uint32_t>(i));
+	}
+
+	std::stable_sort(order.begin(), order.end(), [](const auto& a, const auto& b){ return a.first > b.first; });
+
+	std::vector<uint32_t> indices;
+	std::vector<Meshlet> sorted;
+	indices.reserve(mesh.indices.size());
+	sorted.reserve(meshlets.size());
+	for (const auto& [score, i] : order)
+	{
+		auto meshlet = meshlets[i];
+		const auto first = mesh.indices.begin() + (static_cast<size_t>(meshlet.triangleOffset) * 3);
+		meshlet.triangleOffset = static_cast<uint32_t>(indices.size() / 3);
+		indices.insert(indices.end(), first, first + (static_cast<size_t>(meshlet.triangleCount) * 3));
+		sorted.push_back(meshlet);
+	}
+
+	// Anything past the last whole triangle stays where it was
+	indices.insert(indices.end(), mesh.indices.begin() + static_cast<std::ptrdiff_t>(indices.size()), mesh.indices.end());
+
+	mesh.indices = std::move(indices);
+	meshlets = std::move(sorted);
+}
+
+OptimizedMesh RS::OptimizeMesh(Gadget::MeshData mesh, const MeshOptimizerOptions& options)
+{
+	WeldVertices(mesh);
+	OptimizeVertexCache(mesh.indices, mesh.vertices.size(), options.cacheSize);
+
+	OptimizedMesh result;
+	result.meshlets = BuildMeshlets(mesh, options.maxMeshletVertices, options.maxMeshletTriangles);
+	OptimizeOverdraw(mesh, result.meshlets);
+
+	// Only renumbers vertices, so the meshlets stay valid
+	OptimizeVertexFetch(mesh);
+	result.bounds = ComputeMeshBounds(mesh.vertices);
+	result.mesh = std::move(mesh);
+	return result;
+}
@@ -0,0 +1,125 @@
+#include "Present.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <SDL3/SDL.h>
+
+#include "Profiler.hpp"
+
+using namespace RS;
+
+static constexpr bool IsRgba = std::is_same_v<FrameBuffer::ColorT, PixelRGBA8>;
+static constexpr SDL_PixelFormat ColorFormat = IsRgba ? SDL_PIXELFORMAT_RGBA32 : SDL_PIXELFORMAT_BGRA32;
+
+static bool HasSameLayout(SDL_PixelFormat surfaceFormat)
+{
+	// Surfaces with an unused alpha channel have the same memory layout
+	if constexpr (IsRgba)
+	{
+		return surfaceFormat == SDL_PIXELFORMAT_RGBA32 || surfaceFormat == SDL_PIXELFORMAT_RGBX32;
+	}
+	else
+	{
+		return surfaceFormat == SDL_PIXELFORMAT_BGRA32 || surfaceFormat == SDL_PIXELFORMAT_BGRX32;
+	}
+}
+
+// Copies the top left width x height pixels of the target, which has to be the frame buffer's color target
+template <typename Target>
+static void CopyPixels(const Target& color, SDL_Surface* surface, int width, int height)
+{
+	auto* destination = static_cast<uint8_t*>(surface->pixels);
+
+	if constexpr (Target::IsLinear)
+	{
+		const auto* source = color.GetRow(0);
+		const int sourcePitch = static_cast<int>(color.Pitch() * sizeof(FrameBuffer::ColorT));
+
+		if (!HasSameLayout(surface->format))
+		{
+			SDL_ConvertPixels(width, height, ColorFormat, source, sourcePitch, surface->format, destination, surface->pitch);
+		}
+		else if (sourcePitch == surface->pitch && width == color.Width())
+		{
+			std::memcpy(destination, source, static_cast<size_t>(sourcePitch) * height);
+		}
+		else
+		{
+			const auto rowSize = static_cast<size_t>(width) * sizeof(FrameBuffer::ColorT);
+			for (int y = 0; y < height; y++)
+			{
+				std::memcpy(destination + (static_cast<ptrdiff_t>(y) * surface->pitch), color.GetRow(static_cast<uint16_t>(y)), rowSize);
+			}
+		}
+	}
+	else if (HasSameLayout(surface->format) && width == color.Width() && height == color.Height() && surface->pitch % static_cast<int>(sizeof(FrameBuffer::ColorT)) == 0)
+	{
+		// De-swizzles straight into the surface
+		color.CopyTo(reinterpret_cast<FrameBuffer::ColorT*>(destination), static_cast<uint32_t>(surface->pitch) / sizeof(FrameBuffer::ColorT));
+	}
+	else
+	{
+		// SDL only converts linear pixels, so this takes a second pass through a linear copy
+		std::vector<FrameBuffer::ColorT> linear(static_cast<size_t>(color.Width()) * color.Height());
+		color.CopyTo(linear.data(), color.Width());
+
+		const int sourcePitch = static_cast<int>(color.Width() * sizeof(FrameBuffer::ColorT));
+		SDL_ConvertPixels(width, height, ColorFormat, linear.data(), sourcePitch, surface->format, destination, surface->pitch);
+	}
+}
+
+SDL_Window* RS::GetMainSdlWindow()
+{
+	int count = 0;
+	SDL_Window** windows = SDL_GetWindows(&count);
+	SDL_Window* result = (windows != nullptr && count > 0) ? windows[0] : nullptr;
+	SDL_free(static_cast<void*>(windows));
+	return result;
+}
+
+void RS::Present(SDL_Window* window, const FrameBuffer& frameBuffer, const Gadget::Color& backgroundColor)
+{
+	CopyToSurface(SDL_GetWindowSurface(window), frameBuffer, backgroundColor);
+}
+
+bool RS::CanRenderToSurface(const SDL_Surface* surface, const FrameBuffer& frameBuffer)
+{
+	return FrameBuffer::ColorTarget::IsLinear
+		&& surface != nullptr
+		&& HasSameLayout(surface->format)
+		&& surface->w == frameBuffer.Width()
+		&& surface->h == frameBuffer.Height()
+		&& surface->pitch % static_cast<int>(sizeof(FrameBuffer::ColorT)) == 0;
+}
+
+void RS::CopyToSurface(SDL_Surface* surface, const FrameBuffer& frameBuffer, const Gadget::Color& backgroundColor)
+{
+	RS_PROFILE_SCOPE(ProfileStage::Copy);
+
+	if (surface == nullptr)
+	{
+		return;
+	}
+
+	const int width = std::min<int>(surface->w, frameBuffer.Width());
+	const int height = std::min<int>(surface->h, frameBuffer.Height());
+
+	if (width != surface->w || height != surface->h)
+	{
+		const auto background = PackColor<PixelRGBA8>(backgroundColor);
+		SDL_FillSurfaceRect(surface, nullptr, SDL_MapSurfaceRGB(surface, background.r, background.g, background.b));
+	}
+
+	if (width <= 0 || height <= 0 || !SDL_LockSurface(surface))
+	{
+		return;
+	}
+
+	CopyPixels(frameBuffer.color, surface, width, height);
+
+	SDL_UnlockSurface(surface);
+}
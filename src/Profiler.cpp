@@ -0,0 +1,237 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <vector>
+
+using namespace RS;
+
+struct TraceEvent
+{
+	ProfileStage stage;
+	uint64_t frame;
+	uint64_t start;		// Nanoseconds since the profiler started
+	uint64_t duration;	// Nanoseconds
+};
+
+struct ThreadProfile
+{
+	uint32_t index = 0;
+	std::string name;
+	std::array<ProfileHistogram, static_cast<size_t>(ProfileStage::Count)> histograms;
+	std::vector<TraceEvent> events;
+};
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+static std::mutex threadsMutex;
+static std::vector<std::unique_ptr<ThreadProfile>> threads;
+static thread_local ThreadProfile* currentThread = nullptr;
+
+static std::atomic<uint64_t> currentFrame{ std::numeric_limits<uint64_t>::max() }; // Wraps to 0 on the first BeginFrame
+static std::atomic<uint64_t> captureBegin{ 0 };
+static std::atomic<uint64_t> captureEnd{ 0 };
+
+static ThreadProfile& GetThreadProfile()
+{
+	if (currentThread == nullptr)
+	{
+		auto lock = std::lock_guard(threadsMutex);
+		auto& profile = threads.emplace_back(std::make_unique<ThreadProfile>());
+		profile->index = static_cast<uint32_t>(threads.size() - 1);
+		profile->name = "Thread " + std::to_string(profile->index);
+		currentThread = profile.get();
+	}
+
+	return *currentThread;
+}
+
+static double ToMicroseconds(uint64_t nanoseconds)
+{
+	return static_cast<double>(nanoseconds) / 1'000.0;
+}
+
+const char* RS::ToString(ProfileStage stage)
+{
+	static constexpr std::array<const char*, static_cast<size_t>(ProfileStage::Count)> names = {
+		"Frame", "Events", "Setup", "Vertex", "Cull", "Clip", "Raster", "Clear", "Copy", "Present", "Idle"
+	};
+
+	return stage < ProfileStage::Count ? names[static_cast<size_t>(stage)] : "Unknown";
+}
+
+void ProfileHistogram::Merge(const ProfileHistogram& other)
+{
+	for (size_t i = 0; i < NumBuckets; i++)
+	{
+		buckets[i] += other.buckets[i];
+	}
+
+	count += other.count;
+	total += other.total;
+	max = std::max(max, other.max);
+}
+
+uint64_t ProfileHistogram::Percentile(double percent) const
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+
+	const auto rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(count))), 1);
+	uint64_t seen = 0;
+	for (size_t i = 0; i < NumBuckets; i++)
+	{
+		seen += buckets[i];
+		if (seen < rank)
+		{
+			continue;
+		}
+
+		if (i < (size_t{ 1 } << SubBucketBits))
+		{
+			return i;
+		}
+
+		// Inverse of GetBucket, clamped so the top bucket can't report more than was ever recorded
+		const size_t shift = (i >> SubBucketBits) - 1;
+		const uint64_t base = ((uint64_t{ 1 } << SubBucketBits) + (i & ((size_t{ 1 } << SubBucketBits) - 1))) << shift;
+		return std::min(base + (uint64_t{ 1 } << shift) - 1, max);
+	}
+
+	return max;
+}
+
+void Profiler::SetThreadName(std::string name)
+{
+	auto& profile = GetThreadProfile();
+	auto lock = std::lock_guard(threadsMutex);
+	profile.name = std::move(name);
+}
+
+void Profiler::BeginFrame()
+{
+	currentFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::CurrentFrame()
+{
+	return currentFrame.load(std::memory_order_relaxed);
+}
+
+void Profiler::CaptureFrames(uint64_t firstFrame, uint64_t numFrames)
+{
+	captureBegin.store(firstFrame, std::memory_order_relaxed);
+	captureEnd.store(firstFrame + numFrames, std::memory_order_relaxed);
+}
+
+void Profiler::Record(ProfileStage stage, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	auto& profile = GetThreadProfile();
+	const auto duration = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+	profile.histograms[static_cast<size_t>(stage)].Add(duration);
+
+	const uint64_t frame = currentFrame.load(std::memory_order_relaxed);
+	if (frame >= captureBegin.load(std::memory_order_relaxed) && frame < captureEnd.load(std::memory_order_relaxed))
+	{
+		const auto offset = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start - startTime).count());
+		profile.events.push_back(TraceEvent{ stage, frame, offset, duration });
+	}
+}
+
+void Profiler::PrintReport()
+{
+	if constexpr (!IsEnabled)
+	{
+		std::println("Profiling is disabled, rebuild with RS_PROFILING to enable it");
+		return;
+	}
+
+	auto lock = std::lock_guard(threadsMutex);
+
+	std::println("{:<10}{:>10}{:>12}{:>12}{:>12}{:>12}{:>12}{:>12}", "Stage", "Count", "Total ms", "Mean us", "p50 us", "p90 us", "p99 us", "Max us");
+	for (size_t stage = 0; stage < static_cast<size_t>(ProfileStage::Count); stage++)
+	{
+		ProfileHistogram merged;
+		for (const auto& thread : threads)
+		{
+			merged.Merge(thread->histograms[stage]);
+		}
+
+		if (merged.Count() == 0)
+		{
+			continue;
+		}
+
+		std::println("{:<10}{:>10}{:>12.3f}{:>12.2f}{:>12.2f}{:>12.2f}{:>12.2f}{:>12.2f}",
+			ToString(static_cast<ProfileStage>(stage)),
+			merged.Count(),
+			ToMicroseconds(merged.Total()) / 1'000.0,
+			ToMicroseconds(merged.Total()) / static_cast<double>(merged.Count()),
+			ToMicroseconds(merged.Percentile(50.0)),
+			ToMicroseconds(merged.Percentile(90.0)),
+			ToMicroseconds(merged.Percentile(99.0)),
+			ToMicroseconds(merged.Max()));
+	}
+
+	// Pipeline jobs are what gets spread over the pool, so uneven totals here mean uneven load
+	std::println("");
+	std::println("{:<16}{:>10}{:>14}{:>12}", "Thread", "Jobs", "Job time ms", "Idle ms");
+	for (const auto& thread : threads)
+	{
+		uint64_t numJobs = 0;
+		uint64_t jobTime = 0;
+		for (const auto stage : { ProfileStage::Vertex, ProfileStage::Cull, ProfileStage::Clip, ProfileStage::Raster })
+		{
+			numJobs += thread->histograms[static_cast<size_t>(stage)].Count();
+			jobTime += thread->histograms[static_cast<size_t>(stage)].Total();
+		}
+
+		const uint64_t idleTime = thread->histograms[static_cast<size_t>(ProfileStage::Idle)].Total();
+		std::println("{:<16}{:>10}{:>14.3f}{:>12.3f}", thread->name, numJobs, ToMicroseconds(jobTime) / 1'000.0, ToMicroseconds(idleTime) / 1'000.0);
+	}
+}
+
+bool Profiler::WriteTrace(const std::filesystem::path& path)
+{
+	if constexpr (!IsEnabled)
+	{
+		std::println("Profiling is disabled, rebuild with RS_PROFILING to write a trace");
+		return false;
+	}
+
+	FILE* file = std::fopen(path.string().c_str(), "wb");
+	if (file == nullptr)
+	{
+		std::println("Could not open {} for writing", path.string());
+		return false;
+	}
+
+	auto lock = std::lock_guard(threadsMutex);
+
+	std::println(file, "{{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+
+	bool isFirst = true;
+	for (const auto& thread : threads)
+	{
+		std::print(file, "{}{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": {}, \"args\": {{\"name\": \"{}\"}}}}", isFirst ? "" : ",\n", thread->index, thread->name);
+		isFirst = false;
+
+		for (const auto& event : thread->events)
+		{
+			std::print(file, ",\n{{\"name\": \"{}\", \"cat\": \"RenderSoft\", \"ph\": \"X\", \"pid\": 0, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{\"frame\": {}}}}}",
+				ToString(event.stage), thread->index, ToMicroseconds(event.start), ToMicroseconds(event.duration), event.frame);
+		}
+	}
+
+	std::println(file, "\n]}}");
+	std::fclose(file);
+	return true;
+}
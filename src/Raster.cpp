@@ -1,125 +1,110 @@
 #include "Raster.hpp"
 
+#include <cmath>
+#include <utility>
+
 using namespace RS;
 
-Gadget::Vertex Raster::ClipIntersectEdge(const Gadget::Vertex& v0, const Gadget::Vertex& v1, double value0, double value1)
+Raster::ClipVertex Raster::ClipIntersectEdge(const ClipVertex& v0, const ClipVertex& v1, Real value0, Real value1)
 {
 	const auto t = value0 / (value0 - value1);
+	const auto tf = static_cast<float>(t);
+
+	return ClipVertex{
+		ClipPosition::Lerp(v0.position, v1.position, t),
+		(1.0f - tf) * v0.color + tf * v1.color,
+		TexCoord{ ((1.0f - tf) * v0.texCoord.u) + (tf * v1.texCoord.u), ((1.0f - tf) * v0.texCoord.v) + (tf * v1.texCoord.v) }
+	};
+}
+
+uint16_t Raster::ComputeOutcode(const ClipPosition& position)
+{
+	const Real guard = static_cast<Real>(GuardBandScale) * position.w;
 
-	return Gadget::Vertex(
-		(1.0 - t) * v0.position + t * v1.position,
-		(1.0f - static_cast<float>(t)) * v0.color + static_cast<float>(t) * v1.color
-	);
+	uint16_t outcode = 0;
+	outcode |= (position.x < -position.w) ? OutsideLeft : 0;
+	outcode |= (position.x > position.w) ? OutsideRight : 0;
+	outcode |= (position.y < -position.w) ? OutsideBottom : 0;
+	outcode |= (position.y > position.w) ? OutsideTop : 0;
+	outcode |= (position.z < -position.w) ? OutsideNear : 0;
+	outcode |= (position.z > position.w) ? OutsideFar : 0;
+	outcode |= (position.x < -guard) ? OutsideGuardLeft : 0;
+	outcode |= (position.x > guard) ? OutsideGuardRight : 0;
+	outcode |= (position.y < -guard) ? OutsideGuardBottom : 0;
+	outcode |= (position.y > guard) ? OutsideGuardTop : 0;
+	return outcode;
 }
 
-void Raster::ClipTriangle(const Triangle& triangle, const Gadget::Vector4& equation, ClippedTriangleList& result)
+Raster::ClippedTriangleList Raster::ClipTriangle(const Triangle& triangle, uint16_t outcodes)
 {
-	std::array<double, 3> values =
+	struct ClipPlane
 	{
-		Gadget::Vector4::Dot(triangle[0].position, equation),
-		Gadget::Vector4::Dot(triangle[1].position, equation),
-		Gadget::Vector4::Dot(triangle[2].position, equation)
+		Outcode outcode;
+		ClipPosition equation; // Positions with a positive dot product are inside
 	};
 
-	const uint8_t mask = (values[0] < 0.0 ? 1 : 0) | (values[1] < 0.0 ? 2 : 0) | (values[2] < 0.0 ? 4 : 0);
-	switch(mask)
+	constexpr auto guard = static_cast<Real>(GuardBandScale);
+	static constexpr std::array<ClipPlane, 6> planes =
 	{
-		case 0b000:
-			// All vertices are inside allowed half-space
-			// No clipping required, copy the triangle to output
-			result.push_back(triangle);
-			break;
-		case 0b001:
-			// Vertex 0 is outside allowed half-space
-			// Replace it with points on edges 01 and 02
-			// And re-triangulate
-		{
-			auto v01 = ClipIntersectEdge(triangle[0], triangle[1], values[0], values[1]);
-			auto v02 = ClipIntersectEdge(triangle[0], triangle[2], values[0], values[2]);
-			result.push_back({ v01, triangle[1], triangle[2] });
-			result.push_back({ v01, triangle[2], v02 });
-		}
-		break;
-		case 0b010:
-			// Vertex 1 is outside allowed half-space
-			// Replace it with points on edges 10 and 12
-			// And re-triangulate
-		{
-			auto v10 = ClipIntersectEdge(triangle[1], triangle[0], values[1], values[0]);
-			auto v12 = ClipIntersectEdge(triangle[1], triangle[2], values[1], values[2]);
-			result.push_back({ triangle[0], v10, triangle[2] });
-			result.push_back({ triangle[2], v10, v12 });
-		}
-		break;
-		case 0b011:
-			// Vertices 0 and 1 are outside allowed half-space
-			// Replace them with points on edges 02 and 12
-		{
-			auto v02 = ClipIntersectEdge(triangle[0], triangle[2], values[0], values[2]);
-			auto v12 = ClipIntersectEdge(triangle[1], triangle[2], values[1], values[2]);
-			result.push_back({ v02, v12, triangle[2] });
-		}
-		break;
-		case 0b100:
-			// Vertex 2 is outside allowed half-space
-			// Replace it with points on edges 20 and 21
-			// And re-triangulate
+		ClipPlane{ OutsideNear, ClipPosition(0, 0, 1, 1) },
+		ClipPlane{ OutsideFar, ClipPosition(0, 0, -1, 1) },
+		ClipPlane{ OutsideGuardLeft, ClipPosition(1, 0, 0, guard) },
+		ClipPlane{ OutsideGuardRight, ClipPosition(-1, 0, 0, guard) },
+		ClipPlane{ OutsideGuardBottom, ClipPosition(0, 1, 0, guard) },
+		ClipPlane{ OutsideGuardTop, ClipPosition(0, -1, 0, guard) }
+	};
+
+	// Clipped as a polygon rather than a list of triangles, every plane adds at most one vertex
+	using Polygon = StackVector<ClipVertex, 3 + planes.size()>;
+
+	Polygon polygon;
+	for (const auto& vertex : triangle)
+	{
+		polygon.push_back(vertex);
+	}
+
+	Polygon clipped;
+	for (const auto& plane : planes)
+	{
+		if ((outcodes & plane.outcode) == 0)
 		{
-			auto v20 = ClipIntersectEdge(triangle[2], triangle[0], values[2], values[0]);
-			auto v21 = ClipIntersectEdge(triangle[2], triangle[1], values[2], values[1]);
-			result.push_back({ triangle[0], triangle[1], v20 });
-			result.push_back({ v20, triangle[1], v21 });
+			continue;
 		}
-		break;
-		case 0b101:
-			// Vertices 0 and 2 are outside allowed half-space
-			// Replace them with points on edges 01 and 21
+
+		clipped.clear();
+		for (size_t i = 0; i < polygon.size(); i++)
 		{
-			auto v01 = ClipIntersectEdge(triangle[0], triangle[1], values[0], values[1]);
-			auto v21 = ClipIntersectEdge(triangle[2], triangle[1], values[2], values[1]);
-			result.push_back({ v01, triangle[1], v21 });
+			const auto& current = polygon[i];
+			const auto& next = polygon[(i + 1) % polygon.size()];
+			const Real currentValue = ClipPosition::Dot(current.position, plane.equation);
+			const Real nextValue = ClipPosition::Dot(next.position, plane.equation);
+
+			if (currentValue >= 0)
+			{
+				clipped.push_back(current);
+			}
+
+			// Always interpolate from the inside vertex so that triangles sharing the edge get the exact same new vertex
+			if ((currentValue >= 0) != (nextValue >= 0))
+			{
+				clipped.push_back(currentValue >= 0 ? ClipIntersectEdge(current, next, currentValue, nextValue) : ClipIntersectEdge(next, current, nextValue, currentValue));
+			}
 		}
-		break;
-		case 0b110:
-			// Vertices 1 and 2 are outside allowed half-space
-			// Replace them with points on edges 10 and 20
+
+		std::swap(polygon, clipped);
+		if (polygon.size() < 3)
 		{
-			auto v10 = ClipIntersectEdge(triangle[1], triangle[0], values[1], values[0]);
-			auto v20 = ClipIntersectEdge(triangle[2], triangle[0], values[2], values[0]);
-			result.push_back({ triangle[0], v10, v20 });
+			return {};
 		}
-		break;
-		case 0b111:
-			// All vertices are outside allowed half-space
-			// Clip the whole triangle, result is empty
-			break;
 	}
-}
 
-Raster::ClippedTriangleList Raster::ClipTriangle(Triangle inTriangle)
-{
-	static const std::array<Gadget::Vector4, 2> equations =
+	ClippedTriangleList result;
+	for (size_t i = 1; i + 1 < polygon.size(); i++)
 	{
-		Gadget::Vector4(0.0, 0.0, 1.0, 1.0),
-		Gadget::Vector4(0.0, 0.0, -1.0, 1.0)
-	};
-
-	ClippedTriangleList eq1Result;
-	eq1Result.reserve(12);
-
-	// Equation 1 - only one triangle to clip
-	ClipTriangle(inTriangle, equations[0], eq1Result);
-
-	// Equation 2 - possibly more than one triangle
-	ClippedTriangleList eq2Result;
-	eq2Result.reserve(12);
-
-	for(const auto& tri : eq1Result)
-	{
-		ClipTriangle(tri, equations[1], eq2Result);
+		result.push_back({ polygon[0], polygon[i], polygon[i + 1] });
 	}
 
-	return eq2Result;
+	return result;
 }
 
 bool Raster::DepthTest(RS::DepthTestMode mode, uint32_t value, uint32_t reference)
@@ -146,3 +131,43 @@ bool Raster::DepthTest(RS::DepthTestMode mode, uint32_t value, uint32_t referenc
 
 	return true;
 }
+
+int64_t Raster::ToFixedPoint(double value)
+{
+	return std::llround(value * static_cast<double>(SubPixelScale));
+}
+
+Raster::EdgeFunction Raster::SetupEdge(int64_t x0, int64_t y0, int64_t x1, int64_t y1)
+{
+	const int64_t a = y0 - y1;
+	const int64_t b = x1 - x0;
+
+	// Top-left fill rule - pixels exactly on a shared edge belong to only one of the triangles
+	// With y pointing down and positive area, left edges go up and top edges are horizontal going right
+	const bool isTopLeft = a > 0 || (a == 0 && b > 0);
+	const int64_t bias = isTopLeft ? 0 : -1;
+
+	// Sample at pixel centers
+	constexpr int64_t halfPixel = SubPixelScale / 2;
+
+	EdgeFunction edge;
+	edge.stepX = a * SubPixelScale;
+	edge.stepY = b * SubPixelScale;
+	edge.origin = (a * (halfPixel - x0)) + (b * (halfPixel - y0)) + bias;
+	return edge;
+}
+
+Raster::AttributePlane Raster::SetupAttribute(const std::array<EdgeFunction, 3>& edges, Real invArea, int32_t x, int32_t y, Real a0, Real a1, Real a2)
+{
+	// Edge i is opposite vertex i, so its value over the area is vertex i's barycentric
+	// Summed in double whatever the pipeline's precision, the edge values are large and the terms partly cancel
+	const double s0 = static_cast<double>(a0) * invArea;
+	const double s1 = static_cast<double>(a1) * invArea;
+	const double s2 = static_cast<double>(a2) * invArea;
+
+	AttributePlane plane;
+	plane.stepX = static_cast<Real>((s0 * static_cast<double>(edges[0].stepX)) + (s1 * static_cast<double>(edges[1].stepX)) + (s2 * static_cast<double>(edges[2].stepX)));
+	plane.stepY = static_cast<Real>((s0 * static_cast<double>(edges[0].stepY)) + (s1 * static_cast<double>(edges[1].stepY)) + (s2 * static_cast<double>(edges[2].stepY)));
+	plane.origin = static_cast<Real>((s0 * static_cast<double>(edges[0].Evaluate(x, y))) + (s1 * static_cast<double>(edges[1].Evaluate(x, y))) + (s2 * static_cast<double>(edges[2].Evaluate(x, y))));
+	return plane;
+}
@@ -0,0 +1,372 @@
+#include "RasterKernels.hpp"
+
+#if defined(RS_SIMD_ENABLED)
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <utility>
+
+#include <immintrin.h>
+
+using namespace RS;
+
+static constexpr int32_t LaneCount = 8;
+static_assert(FrameBuffer::ColorTarget::SpanWidth % LaneCount == 0 && FrameBuffer::DepthTarget::SpanWidth % LaneCount == 0, "Every block of lanes has to be contiguous in the frame buffer");
+
+// AVX2 only has signed 32-bit comparisons
+static inline __m256i CompareGreaterU32(__m256i a, __m256i b)
+{
+	const __m256i signBit = _mm256_set1_epi32(std::numeric_limits<int32_t>::min());
+	return _mm256_cmpgt_epi32(_mm256_xor_si256(a, signBit), _mm256_xor_si256(b, signBit));
+}
+
+template <DepthTestMode Mode>
+static inline __m256i DepthTestMask(__m256i value, __m256i reference)
+{
+	const __m256i allSet = _mm256_set1_epi32(-1);
+
+	if constexpr (Mode == DepthTestMode::Always)
+	{
+		return allSet;
+	}
+	else if constexpr (Mode == DepthTestMode::Never)
+	{
+		return _mm256_setzero_si256();
+	}
+	else if constexpr (Mode == DepthTestMode::Less)
+	{
+		return CompareGreaterU32(reference, value);
+	}
+	else if constexpr (Mode == DepthTestMode::LessEqual)
+	{
+		return _mm256_xor_si256(CompareGreaterU32(value, reference), allSet);
+	}
+	else if constexpr (Mode == DepthTestMode::Greater)
+	{
+		return CompareGreaterU32(value, reference);
+	}
+	else if constexpr (Mode == DepthTestMode::GreaterEqual)
+	{
+		return _mm256_xor_si256(CompareGreaterU32(reference, value), allSet);
+	}
+	else if constexpr (Mode == DepthTestMode::Equal)
+	{
+		return _mm256_cmpeq_epi32(value, reference);
+	}
+	else
+	{
+		return _mm256_xor_si256(_mm256_cmpeq_epi32(value, reference), allSet);
+	}
+}
+
+#if defined(RS_PIPELINE_PRECISION_FLOAT)
+// Converts NDC z to the depth buffer's representation, truncating the same way QuantizeDepth does
+static inline __m256i NdcToDepth(__m256 z)
+{
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 scale = _mm256_set1_ps(Raster::MaxQuantizedDepth);
+	const __m256 signedLimit = _mm256_set1_ps(2147483648.0f);
+
+	__m256 depth = _mm256_mul_ps(_mm256_add_ps(half, _mm256_mul_ps(half, z)), scale);
+	depth = _mm256_min_ps(_mm256_max_ps(depth, _mm256_setzero_ps()), scale);
+
+	// There's no unsigned conversion. Depths past the signed range are shifted into it, which is exact since they're multiples of 256
+	const __m256i low = _mm256_cvttps_epi32(depth);
+	const __m256i high = _mm256_xor_si256(_mm256_cvttps_epi32(_mm256_sub_ps(depth, signedLimit)), _mm256_set1_epi32(std::numeric_limits<int32_t>::min()));
+	return _mm256_blendv_epi8(low, high, _mm256_castps_si256(_mm256_cmp_ps(depth, signedLimit, _CMP_GE_OQ)));
+}
+
+// Depth of every lane in the block dx, dy pixels from the triangle's top left, all eight from one register
+static inline __m256i InterpolateDepth(const Raster::AttributePlane& plane, int32_t dx, int32_t dy)
+{
+	const __m256 laneIndex = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+	return NdcToDepth(_mm256_add_ps(_mm256_set1_ps(plane.Evaluate(dx, dy)), _mm256_mul_ps(laneIndex, _mm256_set1_ps(plane.stepX))));
+}
+#else
+// Converts NDC z to the depth buffer's representation, truncating the same way QuantizeDepth does
+static inline __m128i NdcToDepth(__m256d z)
+{
+	const __m256d half = _mm256_set1_pd(0.5);
+	const __m256d scale = _mm256_set1_pd(Raster::MaxQuantizedDepth);
+
+	__m256d depth = _mm256_mul_pd(_mm256_add_pd(half, _mm256_mul_pd(half, z)), scale);
+	depth = _mm256_floor_pd(_mm256_min_pd(_mm256_max_pd(depth, _mm256_setzero_pd()), scale));
+
+	// There's no unsigned conversion, so shift into signed range and flip the sign bit back afterwards
+	const __m128i shifted = _mm256_cvttpd_epi32(_mm256_sub_pd(depth, _mm256_set1_pd(2147483648.0)));
+	return _mm_xor_si128(shifted, _mm_set1_epi32(std::numeric_limits<int32_t>::min()));
+}
+
+// Depth of every lane in the block dx, dy pixels from the triangle's top left, four lanes per register
+static inline __m256i InterpolateDepth(const Raster::AttributePlane& plane, int32_t dx, int32_t dy)
+{
+	const __m256d zBase = _mm256_set1_pd(plane.Evaluate(dx, dy));
+	const __m256d zStep = _mm256_set1_pd(plane.stepX);
+	return _mm256_set_m128i(
+		NdcToDepth(_mm256_add_pd(zBase, _mm256_mul_pd(_mm256_setr_pd(4.0, 5.0, 6.0, 7.0), zStep))),
+		NdcToDepth(_mm256_add_pd(zBase, _mm256_mul_pd(_mm256_setr_pd(0.0, 1.0, 2.0, 3.0), zStep)))
+	);
+}
+#endif
+
+// Converts [0, 1] floats to packed 8-bit channels in the frame buffer's color format, rounding the same way PackColor does
+static inline __m256i PackColorLanes(__m256 red, __m256 green, __m256 blue, __m256 alpha)
+{
+	using ColorT = FrameBuffer::ColorT;
+
+	const auto packChannel = [](__m256 value, int shift)
+	{
+		value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+		const __m256i channel = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+		return _mm256_sll_epi32(channel, _mm_cvtsi32_si128(shift));
+	};
+
+	return _mm256_or_si256(
+		_mm256_or_si256(packChannel(red, ColorT::RedShift), packChannel(green, ColorT::GreenShift)),
+		_mm256_or_si256(packChannel(blue, ColorT::BlueShift), packChannel(alpha, ColorT::AlphaShift))
+	);
+}
+
+// Approximate reciprocal refined with one Newton-Raphson step, good to about 22 bits without a division
+static inline __m256 Reciprocal(__m256 value)
+{
+	const __m256 estimate = _mm256_rcp_ps(value);
+	return _mm256_mul_ps(estimate, _mm256_sub_ps(_mm256_set1_ps(2.0f), _mm256_mul_ps(value, estimate)));
+}
+
+static inline int32_t ClampEdgeValue(int64_t value)
+{
+	return static_cast<int32_t>(std::clamp(value, -Raster::MaxSimdEdgeValue, Raster::MaxSimdEdgeValue));
+}
+
+template <Raster::PipelineState State>
+static void RasterizeTile(const BinnedTriangle& tri, const TileRect& tile, const BlockMask& blocks, FrameBuffer& frameBuffer, const TextureSampler& sampler, PipelineStatistics* statistics)
+{
+	if (!Raster::CanUseSimdKernel(tri))
+	{
+		Raster::GetScalarTileKernels()[State.Index()](tri, tile, blocks, frameBuffer, sampler, statistics);
+		return;
+	}
+
+	// Always without depth writes never reads the depth buffer, so it doesn't need the triangle's depth either
+	constexpr bool usesDepth = State.writeDepth || State.depthMode != DepthTestMode::Always;
+
+	const int32_t minX = std::max(tri.minX, tile.minX);
+	const int32_t minY = std::max(tri.minY, tile.minY);
+	const int32_t maxX = std::min(tri.maxX, tile.maxX);
+	const int32_t maxY = std::min(tri.maxY, tile.maxY);
+
+	// Tiles are a multiple of the block width, so aligned blocks never reach into a neighbouring tile
+	const int32_t blockMinX = minX & ~(LaneCount - 1);
+
+	const auto& edges = tri.edges;
+	const __m256i laneIndex = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256 laneIndexF = _mm256_cvtepi32_ps(laneIndex);
+	const __m256i minXMinusOne = _mm256_set1_epi32(minX - 1);
+	const __m256i maxXVec = _mm256_set1_epi32(maxX);
+
+	const __m256i edgeOffset0 = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int32_t>(edges[0].stepX)), laneIndex);
+	const __m256i edgeOffset1 = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int32_t>(edges[1].stepX)), laneIndex);
+	const __m256i edgeOffset2 = _mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int32_t>(edges[2].stepX)), laneIndex);
+
+	// Attributes are linear across a block, so each block evaluates their planes once and the lanes add multiples of the x step
+	const auto& colorPlanes = tri.color;
+	const __m256 invWStep = _mm256_set1_ps(static_cast<float>(tri.invW.stepX));
+	const std::array<float, 4> colorStep = {
+		static_cast<float>(colorPlanes[0].stepX),
+		static_cast<float>(colorPlanes[1].stepX),
+		static_cast<float>(colorPlanes[2].stepX),
+		static_cast<float>(colorPlanes[3].stepX)
+	};
+	const std::array<float, 2> texCoordStep = { static_cast<float>(tri.texCoord[0].stepX), static_cast<float>(tri.texCoord[1].stepX) };
+
+	alignas(32) std::array<std::array<float, LaneCount>, 4> colorLanes{};
+	alignas(32) std::array<std::array<float, LaneCount>, 2> texCoordLanes{};
+	Raster::BlockLodCache lodCache;
+
+	for (int32_t y = minY; y < maxY; y++)
+	{
+		const int32_t blockRow = ((y - tile.minY) / HiZBuffer::BlockSize) * HiZBuffer::BlocksPerTileSide;
+		const auto visibleRow = static_cast<uint8_t>(blocks.visible >> blockRow);
+		const auto acceptedRow = static_cast<uint8_t>(blocks.accepted >> blockRow);
+		const auto coveredRow = static_cast<uint8_t>(blocks.covered >> blockRow);
+		if (visibleRow == 0)
+		{
+			continue;
+		}
+
+		std::array<int64_t, 3> w = { edges[0].Evaluate(blockMinX, y), edges[1].Evaluate(blockMinX, y), edges[2].Evaluate(blockMinX, y) };
+
+		for (int32_t x = blockMinX; x < maxX; x += LaneCount)
+		{
+			// Lanes never straddle two depth blocks, so the whole lane block is in or out
+			const int32_t blockColumn = (x - tile.minX) / HiZBuffer::BlockSize;
+			if (((visibleRow >> blockColumn) & 1) == 0)
+			{
+				for (size_t i = 0; i < 3; i++)
+				{
+					w[i] += edges[i].stepX * LaneCount;
+				}
+				continue;
+			}
+
+			const __m256i xs = _mm256_add_epi32(_mm256_set1_epi32(x), laneIndex);
+			const __m256i inRange = _mm256_and_si256(_mm256_cmpgt_epi32(xs, minXMinusOne), _mm256_cmpgt_epi32(maxXVec, xs));
+
+			// Blocks the triangle covers completely skip the edge tests
+			__m256i coverage = inRange;
+			if (((coveredRow >> blockColumn) & 1) == 0)
+			{
+				const __m256i w0 = _mm256_add_epi32(_mm256_set1_epi32(ClampEdgeValue(w[0])), edgeOffset0);
+				const __m256i w1 = _mm256_add_epi32(_mm256_set1_epi32(ClampEdgeValue(w[1])), edgeOffset1);
+				const __m256i w2 = _mm256_add_epi32(_mm256_set1_epi32(ClampEdgeValue(w[2])), edgeOffset2);
+
+				// Any sign bit set means the lane is outside
+				const __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(w0, w1), w2), 31);
+				coverage = _mm256_andnot_si256(outside, inRange);
+			}
+
+			for (size_t i = 0; i < 3; i++)
+			{
+				w[i] += edges[i].stepX * LaneCount;
+			}
+
+			if (_mm256_testz_si256(coverage, coverage) != 0)
+			{
+				continue;
+			}
+
+			const int32_t dx = x - tri.minX;
+			const int32_t dy = y - tri.minY;
+			auto* depthSpan = reinterpret_cast<int*>(frameBuffer.depth.GetSpan(static_cast<uint16_t>(x), static_cast<uint16_t>(y)));
+			auto* colorSpan = reinterpret_cast<int*>(frameBuffer.color.GetSpan(static_cast<uint16_t>(x), static_cast<uint16_t>(y)));
+			__m256i depth = _mm256_setzero_si256();
+			if constexpr (usesDepth)
+			{
+				depth = InterpolateDepth(tri.depth, dx, dy);
+			}
+
+			const bool accepted = ((acceptedRow >> blockColumn) & 1) != 0;
+			__m256i pass = coverage;
+			if (State.depthMode != DepthTestMode::Always && !accepted)
+			{
+				const __m256i reference = _mm256_maskload_epi32(depthSpan, coverage);
+				pass = _mm256_and_si256(DepthTestMask<State.depthMode>(depth, reference), coverage);
+			}
+
+			const int passMask = _mm256_movemask_ps(_mm256_castsi256_ps(pass));
+			if (statistics != nullptr)
+			{
+				Raster::AddPixelStatistics(*statistics, _mm256_movemask_ps(_mm256_castsi256_ps(coverage)), passMask, accepted, State.writeColor);
+			}
+
+			if (passMask == 0)
+			{
+				continue;
+			}
+
+			if constexpr (State.writeDepth)
+			{
+				_mm256_maskstore_epi32(depthSpan, pass, depth);
+			}
+
+			if constexpr (!State.writeColor)
+			{
+				continue;
+			}
+
+			const auto interpolateColor = [&](size_t i){ return _mm256_add_ps(_mm256_set1_ps(static_cast<float>(colorPlanes[i].Evaluate(dx, dy))), _mm256_mul_ps(laneIndexF, _mm256_set1_ps(colorStep[i]))); };
+			__m256 red = interpolateColor(0);
+			__m256 green = interpolateColor(1);
+			__m256 blue = interpolateColor(2);
+			__m256 alpha = interpolateColor(3);
+
+			__m256 wLanes = _mm256_set1_ps(1.0f);
+			if constexpr (State.isPerspective)
+			{
+				wLanes = Reciprocal(_mm256_add_ps(_mm256_set1_ps(static_cast<float>(tri.invW.Evaluate(dx, dy))), _mm256_mul_ps(laneIndexF, invWStep)));
+				red = _mm256_mul_ps(red, wLanes);
+				green = _mm256_mul_ps(green, wLanes);
+				blue = _mm256_mul_ps(blue, wLanes);
+				alpha = _mm256_mul_ps(alpha, wLanes);
+			}
+
+			// Texels live in micro-tiles, which a gather doesn't help with, so they're fetched lane by lane
+			// and the lanes reloaded with the modulated colors
+			if constexpr (State.isTextured)
+			{
+				const auto interpolateTexCoord = [&](size_t i){ return _mm256_add_ps(_mm256_set1_ps(static_cast<float>(tri.texCoord[i].Evaluate(dx, dy))), _mm256_mul_ps(laneIndexF, _mm256_set1_ps(texCoordStep[i]))); };
+				_mm256_store_ps(texCoordLanes[0].data(), _mm256_mul_ps(interpolateTexCoord(0), wLanes));
+				_mm256_store_ps(texCoordLanes[1].data(), _mm256_mul_ps(interpolateTexCoord(1), wLanes));
+				_mm256_store_ps(colorLanes[0].data(), red);
+				_mm256_store_ps(colorLanes[1].data(), green);
+				_mm256_store_ps(colorLanes[2].data(), blue);
+				_mm256_store_ps(colorLanes[3].data(), alpha);
+
+				// One LOD per depth block, a lane block is one row of it
+				const auto firstLane = static_cast<int32_t>(std::countr_zero(static_cast<uint32_t>(passMask)));
+				const float lod = lodCache.Get(blockRow, blockColumn, [&]{
+					return Raster::TextureLod(tri, State.isPerspective, dx + firstLane, dy, *sampler.texture);
+				});
+				for (int32_t lane = firstLane; lane < LaneCount; lane++)
+				{
+					if ((passMask & (1 << lane)) == 0)
+					{
+						continue;
+					}
+
+					const auto texel = sampler.Sample(texCoordLanes[0][lane], texCoordLanes[1][lane], lod);
+					const auto color = Raster::Modulate(Gadget::Color(colorLanes[0][lane], colorLanes[1][lane], colorLanes[2][lane], colorLanes[3][lane]), texel);
+					colorLanes[0][lane] = color.r;
+					colorLanes[1][lane] = color.g;
+					colorLanes[2][lane] = color.b;
+					colorLanes[3][lane] = color.a;
+				}
+
+				red = _mm256_load_ps(colorLanes[0].data());
+				green = _mm256_load_ps(colorLanes[1].data());
+				blue = _mm256_load_ps(colorLanes[2].data());
+				alpha = _mm256_load_ps(colorLanes[3].data());
+			}
+
+			if constexpr (!State.debugCheckerboard)
+			{
+				_mm256_maskstore_epi32(colorSpan, pass, PackColorLanes(red, green, blue, alpha));
+				continue;
+			}
+
+			_mm256_store_ps(colorLanes[0].data(), red);
+			_mm256_store_ps(colorLanes[1].data(), green);
+			_mm256_store_ps(colorLanes[2].data(), blue);
+			_mm256_store_ps(colorLanes[3].data(), alpha);
+
+			for (int32_t lane = 0; lane < LaneCount; lane++)
+			{
+				if ((passMask & (1 << lane)) == 0)
+				{
+					continue;
+				}
+
+				auto finalColor = Gadget::Color(colorLanes[0][lane], colorLanes[1][lane], colorLanes[2][lane], colorLanes[3][lane]);
+				Raster::ApplyDebugCheckerboard(finalColor);
+				frameBuffer.color.SetPixel(static_cast<uint16_t>(x + lane), static_cast<uint16_t>(y), PackColor<FrameBuffer::ColorT>(finalColor));
+			}
+		}
+	}
+}
+
+template <size_t... Indices>
+static constexpr Raster::TileKernelTable MakeKernelTable(std::index_sequence<Indices...> /* indices */)
+{
+	return { &RasterizeTile<Raster::PipelineState::FromIndex(Indices)>... };
+}
+
+const Raster::TileKernelTable& Raster::GetAvx2TileKernels()
+{
+	static constexpr auto kernels = MakeKernelTable(std::make_index_sequence<PipelineState::Count>());
+	return kernels;
+}
+
+#endif // RS_SIMD_ENABLED
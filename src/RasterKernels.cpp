@@ -0,0 +1,149 @@
+#include "RasterKernels.hpp"
+
+#include <array>
+
+#if defined(RS_SIMD_ENABLED)
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+using namespace RS;
+
+#if defined(RS_SIMD_ENABLED)
+static void CpuId(uint32_t leaf, uint32_t subLeaf, std::array<uint32_t, 4>& regs)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	std::array<int, 4> info{};
+	__cpuidex(info.data(), static_cast<int>(leaf), static_cast<int>(subLeaf));
+	for (size_t i = 0; i < regs.size(); i++)
+	{
+		regs[i] = static_cast<uint32_t>(info[i]);
+	}
+#else
+	__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Returns the OS-enabled register state mask (XCR0)
+static uint64_t ReadXcr0()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return _xgetbv(0);
+#else
+	uint32_t eax = 0;
+	uint32_t edx = 0;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+static bool CpuSupportsSse41()
+{
+	std::array<uint32_t, 4> regs{};
+	CpuId(1, 0, regs);
+	return (regs[2] & (1u << 19)) != 0;
+}
+
+static bool CpuSupportsAvx2()
+{
+	std::array<uint32_t, 4> regs{};
+	CpuId(0, 0, regs);
+	if (regs[0] < 7)
+	{
+		return false;
+	}
+
+	// AVX also needs the OS to save the upper halves of the YMM registers
+	CpuId(1, 0, regs);
+	const bool osxsave = (regs[2] & (1u << 27)) != 0;
+	const bool avx = (regs[2] & (1u << 28)) != 0;
+	if (!osxsave || !avx || (ReadXcr0() & 0b110) != 0b110)
+	{
+		return false;
+	}
+
+	CpuId(7, 0, regs);
+	return (regs[1] & (1u << 5)) != 0;
+}
+#endif
+
+struct SelectedKernels
+{
+	const Raster::TileKernelTable* table;
+	const char* name;
+};
+
+// Checked once, so the table the renderer dispatches to and the name reported for it always agree
+static const SelectedKernels& GetSelectedKernels()
+{
+	static const SelectedKernels selected = []()
+	{
+#if defined(RS_SIMD_ENABLED)
+		if (CpuSupportsAvx2())
+		{
+			return SelectedKernels{ &Raster::GetAvx2TileKernels(), "avx2" };
+		}
+
+		if (CpuSupportsSse41())
+		{
+			return SelectedKernels{ &Raster::GetSse41TileKernels(), "sse4.1" };
+		}
+#endif
+
+		return SelectedKernels{ &Raster::GetScalarTileKernels(), "scalar" };
+	}();
+	return selected;
+}
+
+const Raster::TileKernelTable& Raster::SelectTileKernels()
+{
+	return *GetSelectedKernels().table;
+}
+
+const char* Raster::GetSelectedKernelName()
+{
+	return GetSelectedKernels().name;
+}
+
+Raster::BlockCoverage Raster::ClassifyCoverage(const BinnedTriangle& tri, const TileRect& tile)
+{
+	constexpr int32_t blockSize = HiZBuffer::BlockSize;
+	const int32_t minBlockX = (std::max(tri.minX, tile.minX) - tile.minX) / blockSize;
+	const int32_t minBlockY = (std::max(tri.minY, tile.minY) - tile.minY) / blockSize;
+	const int32_t maxBlockX = (std::min(tri.maxX, tile.maxX) - 1 - tile.minX) / blockSize;
+	const int32_t maxBlockY = (std::min(tri.maxY, tile.maxY) - 1 - tile.minY) / blockSize;
+
+	BlockCoverage result;
+	for (int32_t by = minBlockY; by <= maxBlockY; by++)
+	{
+		for (int32_t bx = minBlockX; bx <= maxBlockX; bx++)
+		{
+			const int32_t x = tile.minX + (bx * blockSize);
+			const int32_t y = tile.minY + (by * blockSize);
+
+			// Edge functions are linear, so their extremes over the block's pixel centers are at its corners
+			bool isOutside = false;
+			bool isInside = true;
+			for (const auto& edge : tri.edges)
+			{
+				const int64_t value = edge.Evaluate(x, y);
+				const int64_t spanX = edge.stepX * (blockSize - 1);
+				const int64_t spanY = edge.stepY * (blockSize - 1);
+				isOutside |= value + std::max<int64_t>(spanX, 0) + std::max<int64_t>(spanY, 0) < 0;
+				isInside &= value + std::min<int64_t>(spanX, 0) + std::min<int64_t>(spanY, 0) >= 0;
+			}
+
+			// Pixels outside the triangle's bounds are never drawn, even if they're inside its edges
+			isInside &= x >= tri.minX && y >= tri.minY && std::min(x + blockSize, tile.maxX) <= tri.maxX && std::min(y + blockSize, tile.maxY) <= tri.maxY;
+
+			const uint64_t bit = uint64_t{ 1 } << ((by * HiZBuffer::BlocksPerTileSide) + bx);
+			result.overlapped |= isOutside ? 0 : bit;
+			result.covered |= isInside ? bit : 0;
+		}
+	}
+
+	return result;
+}
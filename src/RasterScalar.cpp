@@ -0,0 +1,171 @@
+#include "RasterKernels.hpp"
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <utility>
+
+using namespace RS;
+
+// Floats drift too far when depth is stepped across a whole row, so float pipelines evaluate it at every pixel like the SIMD kernels do
+static constexpr bool SteppedDepth = !std::is_same_v<Real, float>;
+
+template <Raster::PipelineState State>
+static void RasterizeTile(const BinnedTriangle& tri, const TileRect& tile, const BlockMask& blocks, FrameBuffer& frameBuffer, const TextureSampler& sampler, PipelineStatistics* statistics)
+{
+	const int32_t minX = std::max(tri.minX, tile.minX);
+	const int32_t minY = std::max(tri.minY, tile.minY);
+	const int32_t maxX = std::min(tri.maxX, tile.maxX);
+	const int32_t maxY = std::min(tri.maxY, tile.maxY);
+
+	const auto& e0 = tri.edges[0];
+	const auto& e1 = tri.edges[1];
+	const auto& e2 = tri.edges[2];
+
+	int64_t row0 = e0.Evaluate(minX, minY);
+	int64_t row1 = e1.Evaluate(minX, minY);
+	int64_t row2 = e2.Evaluate(minX, minY);
+
+	// Attributes step along with the edge functions, relative to the triangle's top left pixel
+	const int32_t dx = minX - tri.minX;
+	const auto& colorPlanes = tri.color;
+	Real rowZ = tri.depth.Evaluate(dx, minY - tri.minY);
+	Real rowInvW = tri.invW.Evaluate(dx, minY - tri.minY);
+	std::array<Real, 4> rowColor = {
+		colorPlanes[0].Evaluate(dx, minY - tri.minY),
+		colorPlanes[1].Evaluate(dx, minY - tri.minY),
+		colorPlanes[2].Evaluate(dx, minY - tri.minY),
+		colorPlanes[3].Evaluate(dx, minY - tri.minY)
+	};
+	std::array<Real, 2> rowTexCoord = {
+		tri.texCoord[0].Evaluate(dx, minY - tri.minY),
+		tri.texCoord[1].Evaluate(dx, minY - tri.minY)
+	};
+
+	Raster::BlockLodCache lodCache;
+
+	for (int32_t y = minY; y < maxY; y++)
+	{
+		const int32_t blockRow = ((y - tile.minY) / HiZBuffer::BlockSize) * HiZBuffer::BlocksPerTileSide;
+		const auto visibleRow = static_cast<uint8_t>(blocks.visible >> blockRow);
+		const auto acceptedRow = static_cast<uint8_t>(blocks.accepted >> blockRow);
+		const auto coveredRow = static_cast<uint8_t>(blocks.covered >> blockRow);
+
+		int64_t w0 = row0;
+		int64_t w1 = row1;
+		int64_t w2 = row2;
+		Real z = rowZ;
+		Real invW = rowInvW;
+		auto color = rowColor;
+		auto texCoord = rowTexCoord;
+
+		for (int32_t x = minX; visibleRow != 0 && x < maxX; x++)
+		{
+			const int32_t blockColumn = (x - tile.minX) / HiZBuffer::BlockSize;
+
+			// Sign bit of any edge set means the pixel is outside, unless the whole block is known to be covered
+			const bool covered = ((coveredRow >> blockColumn) & 1) != 0;
+			if ((covered || (w0 | w1 | w2) >= 0) && ((visibleRow >> blockColumn) & 1) != 0)
+			{
+				const uint32_t depth = Raster::QuantizeDepth(SteppedDepth ? z : tri.depth.Evaluate(x - tri.minX, y - tri.minY));
+
+				const auto px = static_cast<uint16_t>(x);
+				const auto py = static_cast<uint16_t>(y);
+				const bool accepted = ((acceptedRow >> blockColumn) & 1) != 0;
+				const bool passed = accepted || Raster::DepthTest<State.depthMode>(depth, frameBuffer.depth.GetPixel(px, py));
+
+				if (statistics != nullptr)
+				{
+					statistics->coveredPixels++;
+					statistics->depthTestsSkipped += accepted ? 1 : 0;
+					statistics->depthTestsPassed += passed ? 1 : 0;
+					statistics->depthTestsFailed += passed ? 0 : 1;
+					statistics->colorWrites += (State.writeColor && passed) ? 1 : 0;
+				}
+
+				if (passed)
+				{
+					if constexpr (State.writeDepth)
+					{
+						frameBuffer.depth.SetPixel(px, py, depth);
+					}
+
+					if constexpr (State.writeColor)
+					{
+						const Real scale = State.isPerspective ? 1 / invW : 1;
+						auto finalColor = Gadget::Color(
+							static_cast<float>(color[0] * scale),
+							static_cast<float>(color[1] * scale),
+							static_cast<float>(color[2] * scale),
+							static_cast<float>(color[3] * scale)
+						);
+						if constexpr (State.isTextured)
+						{
+							const float lod = lodCache.Get(blockRow, blockColumn, [&]{
+								return Raster::TextureLod(tri, State.isPerspective, x - tri.minX, y - tri.minY, *sampler.texture);
+							});
+
+							const auto u = static_cast<float>(texCoord[0] * scale);
+							const auto v = static_cast<float>(texCoord[1] * scale);
+							finalColor = Raster::Modulate(finalColor, sampler.Sample(u, v, lod));
+						}
+						if constexpr (State.debugCheckerboard)
+						{
+							Raster::ApplyDebugCheckerboard(finalColor);
+						}
+
+						frameBuffer.color.SetPixel(px, py, PackColor<FrameBuffer::ColorT>(finalColor));
+					}
+				}
+			}
+
+			w0 += e0.stepX;
+			w1 += e1.stepX;
+			w2 += e2.stepX;
+			z += tri.depth.stepX;
+			if constexpr (State.writeColor)
+			{
+				invW += tri.invW.stepX;
+				for (size_t i = 0; i < color.size(); i++)
+				{
+					color[i] += colorPlanes[i].stepX;
+				}
+			}
+			if constexpr (State.writeColor && State.isTextured)
+			{
+				texCoord[0] += tri.texCoord[0].stepX;
+				texCoord[1] += tri.texCoord[1].stepX;
+			}
+		}
+
+		row0 += e0.stepY;
+		row1 += e1.stepY;
+		row2 += e2.stepY;
+		rowZ += tri.depth.stepY;
+		if constexpr (State.writeColor)
+		{
+			rowInvW += tri.invW.stepY;
+			for (size_t i = 0; i < rowColor.size(); i++)
+			{
+				rowColor[i] += colorPlanes[i].stepY;
+			}
+		}
+		if constexpr (State.writeColor && State.isTextured)
+		{
+			rowTexCoord[0] += tri.texCoord[0].stepY;
+			rowTexCoord[1] += tri.texCoord[1].stepY;
+		}
+	}
+}
+
+template <size_t... Indices>
+static constexpr Raster::TileKernelTable MakeKernelTable(std::index_sequence<Indices...> /* indices */)
+{
+	return { &RasterizeTile<Raster::PipelineState::FromIndex(Indices)>... };
+}
+
+const Raster::TileKernelTable& Raster::GetScalarTileKernels()
+{
+	static constexpr auto kernels = MakeKernelTable(std::make_index_sequence<PipelineState::Count>());
+	return kernels;
+}
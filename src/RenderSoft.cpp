@@ -1,207 +1,229 @@
 #include "RenderSoft.hpp"
 
+#include <algorithm>
+#include <charconv>
 #include <chrono>
+#include <optional>
 #include <print>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
 
-#include <GCore/ThreadPool.hpp>
 #include <GCore/Window.hpp>
 #include <GCore/Graphics/MeshData.hpp>
-#include <GCore/Graphics/MeshLoader.hpp>
 
 #include "DrawCall.hpp"
 #include "FrameBuffer.hpp"
 #include "FrameCounter.hpp"
+#include "Headless.hpp"
+#include "MeshCache.hpp"
+#include "Profiler.hpp"
 #include "MeshAssets.hpp"
-#include "Raster.hpp"
+#include "Present.hpp"
+#include "RasterKernels.hpp"
+#include "Renderer.hpp"
+#include "SwapChain.hpp"
 #include "Viewport.hpp"
 
-std::array<std::mutex, 32> depthBufferMutices;
-
-static void Rasterize(const RS::Raster::Triangle& tri, const RS::Viewport& viewport, RS::FrameBuffer& frameBuffer, const RS::DrawCall& drawCall)
+// Value following the given flag, if it's there
+static std::optional<std::string_view> GetArgument(std::span<char*> args, std::string_view name)
 {
-	auto vert0 = tri[0];
-	auto vert1 = tri[1];
-	auto vert2 = tri[2];
+	for (size_t i = 1; i + 1 < args.size(); i++)
+	{
+		if (std::string_view(args[i]) == name)
+		{
+			return std::string_view(args[i + 1]);
+		}
+	}
 
-	auto projVert0 = vert0.position / vert0.position.w;
-	auto projVert1 = vert1.position / vert1.position.w;
-	auto projVert2 = vert2.position / vert2.position.w;
+	return std::nullopt;
+}
 
-	auto v0 = viewport.NdcToViewport(projVert0);
-	auto v1 = viewport.NdcToViewport(projVert1);
-	auto v2 = viewport.NdcToViewport(projVert2);
+static bool HasFlag(std::span<char*> args, std::string_view name)
+{
+	return std::ranges::any_of(args.subspan(1), [name](const char* arg){ return std::string_view(arg) == name; });
+}
 
-	auto det012 = Gadget::Vector2::Determinant(v1 - v0, v2 - v0);
-	if (Gadget::Math::IsNearZero(det012))
+static std::optional<uint32_t> ParseNumber(std::string_view text)
+{
+	uint32_t value = 0;
+	const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+	if (result.ec != std::errc() || result.ptr != text.data() + text.size())
 	{
-		return; // Early out, triangle is very very small
+		return std::nullopt;
 	}
 
-	const bool ccw = det012 < 0.0;
-	if (ccw && drawCall.mode == RS::CullMode::CW || !ccw && drawCall.mode == RS::CullMode::CCW)
+	return value;
+}
+
+// --present copy|direct|pipelined, copy if it's missing or unknown
+static RS::PresentMode ParsePresentMode(std::span<char*> args)
+{
+	const auto value = GetArgument(args, "--present");
+	if (!value.has_value())
 	{
-		return; // Skip this triangle (back-face culling)
+		return RS::PresentMode::Copy;
 	}
 
-	if (ccw)
+	if (*value == "copy")
+	{
+		return RS::PresentMode::Copy;
+	}
+	else if (*value == "direct")
+	{
+		return RS::PresentMode::Direct;
+	}
+	else if (*value == "pipelined")
 	{
-		std::swap(vert1, vert2);
-		std::swap(projVert1, projVert2);
-		std::swap(v1, v2);
-		det012 = -det012;
+		return RS::PresentMode::Pipelined;
 	}
 
-	auto c0 = vert0.color;
-	auto c1 = vert1.color;
-	auto c2 = vert2.color;
+	std::println("Unknown present mode '{}', expected copy, direct or pipelined", *value);
+	return RS::PresentMode::Copy;
+}
 
-	std::array<Gadget::Vector2, 3> verts = { v0, v1, v2 };
-	auto bounds = Gadget::Math::CalculateBounds<double>(verts); // TODO - span was a nice idea, but the dev UX here kinda blows
+// --headless [--frames N] [--scene teapot|cube|rect] [--output path] [--capture frame,frame,...] [--stats]
+// Without --capture, only the last frame is written to the output path
+static RS::HeadlessOptions ParseHeadlessOptions(std::span<char*> args)
+{
+	RS::HeadlessOptions options;
+	options.printStatistics = HasFlag(args, "--stats");
 
-	if (bounds.min.x >= frameBuffer.Width() || bounds.min.y >= frameBuffer.Height() || bounds.max.x < 0.0 || bounds.max.y < 0.0)
+	if (const auto frames = GetArgument(args, "--frames"); frames.has_value())
 	{
-		return; // Early out, triangle bounds are fully off-screen
+		options.numFrames = ParseNumber(*frames).value_or(options.numFrames);
 	}
 
-	// Ignore any part of the bounds that are off-screen
-	bounds.min.x = std::max<double>(bounds.min.x, viewport.GetXMin());
-	bounds.min.y = std::max<double>(bounds.min.y, viewport.GetYMin());
-	bounds.max.x = std::min<double>(std::min<double>(bounds.max.x, frameBuffer.Width() - 1), viewport.GetXMax());
-	bounds.max.y = std::min<double>(std::min<double>(bounds.max.y, frameBuffer.Height() - 1), viewport.GetYMax());
-
-	for (int y = bounds.min.y; y < bounds.max.y; y++)
+	if (const auto scene = GetArgument(args, "--scene"); scene.has_value())
 	{
-		for (int x = bounds.min.x; x < bounds.max.x; x++)
+		if (*scene == "teapot")
+		{
+			options.scene = RS::Scene::Teapot;
+		}
+		else if (*scene == "cube")
+		{
+			options.scene = RS::Scene::Cube;
+		}
+		else if (*scene == "rect")
 		{
-			auto p = Gadget::Vector2(static_cast<double>(x) + 0.5, static_cast<double>(y) + 0.5);
+			options.scene = RS::Scene::Rect;
+		}
+		else
+		{
+			std::println("Unknown scene '{}', expected teapot, cube or rect", *scene);
+		}
+	}
 
-			const auto det01p = Gadget::Vector2::Determinant(v1 - v0, p - v0);
-			const auto det12p = Gadget::Vector2::Determinant(v2 - v1, p - v1);
-			const auto det20p = Gadget::Vector2::Determinant(v0 - v2, p - v2);
+	if (const auto output = GetArgument(args, "--output"); output.has_value())
+	{
+		options.outputPath = std::string(*output);
+	}
 
-			if (det01p >= 0.0 && det12p >= 0.0 && det20p >= 0.0)
+	if (const auto capture = GetArgument(args, "--capture"); capture.has_value())
+	{
+		for (const auto part : std::views::split(*capture, ','))
+		{
+			if (const auto frame = ParseNumber(std::string_view(part.begin(), part.end())); frame.has_value())
 			{
-				auto l0 = det12p / det012;
-				auto l1 = det20p / det012;
-				auto l2 = det01p / det012;
-
-				const auto z = (l0 * projVert0.z) + (l1 * projVert1.z) + (l2 * projVert2.z);
-				const uint32_t depth = (0.5 + 0.5 * z) * std::numeric_limits<uint32_t>::max();
-
-				{
-					const auto pixelIdx = (y * frameBuffer.Height()) + x;
-					auto lock = std::lock_guard(depthBufferMutices.at(pixelIdx % depthBufferMutices.size()));
-					if (!RS::Raster::DepthTest(drawCall.depthMode, depth, frameBuffer.depth.GetPixel(x, y)))
-					{
-						continue;
-					}
-
-					if (drawCall.writeDepth)
-					{
-						frameBuffer.depth.SetPixel(x, y, depth);
-					}
-				}
-
-				l0 /= det012;
-				l1 /= det012;
-				l2 /= det012;
-				const auto lSum = l0 + l1 + l2;
-				l0 /= lSum;
-				l1 /= lSum;
-				l2 /= lSum;
-
-				auto finalColor = (c0 * l0) + (c1 * l1) + (c2 * l2);
-				if (drawCall.debugCheckerboard)
-				{
-					if (static_cast<int>(std::floor(finalColor.r * 8.0) + std::floor(finalColor.g * 8.0)) % 2 == 0)
-					{
-						finalColor = { 0, 0, 0, 255 };
-					}
-					else
-					{
-						finalColor = { 255, 255, 255, 255 };
-					}
-				}
-
-				frameBuffer.color.SetPixel(x, y, finalColor);
+				options.captureFrames.push_back(*frame);
 			}
 		}
 	}
+	else if (options.numFrames > 0)
+	{
+		options.captureFrames.push_back(options.numFrames - 1);
+	}
+
+	return options;
 }
 
-static void Draw(const RS::Viewport& viewport, RS::FrameBuffer& frameBuffer, const RS::DrawCall& drawCall)
+struct TraceOptions
 {
-	static Gadget::ThreadPool threadPool{};
+	std::string path;
+	uint32_t firstFrame = 60;
+	uint32_t numFrames = 10;
+};
+
+// --trace path [--trace-start N] [--trace-frames N]
+// Only does anything when built with RS_PROFILING
+static TraceOptions ParseTraceOptions(std::span<char*> args)
+{
+	TraceOptions options;
+	options.path = std::string(GetArgument(args, "--trace").value_or(""));
 
-	for (size_t i = 0; i + 2 < drawCall.mesh.indices.size(); i += 3)
+	if (const auto start = GetArgument(args, "--trace-start"); start.has_value())
 	{
-		threadPool.QueueJob([&, i]()
-		{
-			const auto i0 = drawCall.mesh.indices[i];
-			const auto i1 = drawCall.mesh.indices[i + 1];
-			const auto i2 = drawCall.mesh.indices[i + 2];
-
-			auto clip0 = drawCall.transform * drawCall.mesh.vertices[i0].position;
-			auto clip1 = drawCall.transform * drawCall.mesh.vertices[i1].position;
-			auto clip2 = drawCall.transform * drawCall.mesh.vertices[i2].position;
-
-			const auto clipVert0 = Gadget::Vertex(clip0, drawCall.mesh.vertices[i0].color);
-			const auto clipVert1 = Gadget::Vertex(clip1, drawCall.mesh.vertices[i1].color);
-			const auto clipVert2 = Gadget::Vertex(clip2, drawCall.mesh.vertices[i2].color);
+		options.firstFrame = ParseNumber(*start).value_or(options.firstFrame);
+	}
 
-			// To disable view clipping, just rasterize the triangle directly
-			//Rasterize({ clipVert0, clipVert1, clipVert2 }, viewport, frameBuffer, drawCall);
+	if (const auto frames = GetArgument(args, "--trace-frames"); frames.has_value())
+	{
+		options.numFrames = ParseNumber(*frames).value_or(options.numFrames);
+	}
 
-			const auto clippedTris = RS::Raster::ClipTriangle({ clipVert0, clipVert1, clipVert2 });
+	return options;
+}
 
-			for (const auto& tri : clippedTris)
-			{
-				Rasterize(tri, viewport, frameBuffer, drawCall);
-			}
-		});
+static void FinishProfiling(const TraceOptions& trace)
+{
+	if constexpr (RS::Profiler::IsEnabled)
+	{
+		RS::Profiler::PrintReport();
 	}
 
-	threadPool.Start(4);
-	while (threadPool.IsBusy())
+	if (!trace.path.empty() && RS::Profiler::WriteTrace(trace.path))
 	{
-		continue;
+		std::println("Wrote a trace of frames {} to {} to {}", trace.firstFrame, trace.firstFrame + trace.numFrames - 1, trace.path);
 	}
-	threadPool.Stop();
 }
 
-void CopyFrameBuffer(Gadget::WindowSurfaceView& surfaceView, const RS::FrameBuffer& buffer)
+int main(int argc, char* argv[])
 {
-	for (uint16_t x = 0; x < buffer.Width(); x++)
+	const auto args = std::span(argv, static_cast<size_t>(argc));
+
+	RS_PROFILE_THREAD("Main");
+	const auto trace = ParseTraceOptions(args);
+	if (!trace.path.empty())
 	{
-		for (uint16_t y = 0; y < buffer.Height(); y++)
-		{
-			surfaceView.AssignPixel(x, y, buffer.color.GetPixel(x, y));
-		}
+		RS::Profiler::CaptureFrames(trace.firstFrame, trace.numFrames);
+	}
+
+	if (HasFlag(args, "--headless"))
+	{
+		const int result = RS::RunHeadless(ParseHeadlessOptions(args));
+		FinishProfiling(trace);
+		return result;
 	}
-}
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
-{
 	static constexpr auto screenW = 800;
 	static constexpr auto screenH = 600;
 
 	std::println("Hello, World!");
+	std::println("Using {} raster kernels", RS::Raster::GetSelectedKernelName());
 
 	auto window = std::make_unique<Gadget::Window>(screenW, screenH, Gadget::RenderAPI::None, "Software RasterMan");
+	auto* sdlWindow = RS::GetMainSdlWindow();
 
 	RS::FrameCounter counter;
+	RS::Renderer renderer;
 
 	auto prevTime = std::chrono::system_clock::now().time_since_epoch();
 	auto curTime = prevTime;
 
-	auto frameBuffer = RS::FrameBuffer(screenW, screenH);
+	auto swapChain = RS::SwapChain(sdlWindow, renderer.GetJobSystem(), screenW, screenH, ParsePresentMode(args));
 
 	auto viewport = RS::Viewport(0, screenW, 0, screenH);
 
 	auto rectMesh = RS::GetRectMesh();
 	auto cubeMesh = RS::GetCubeMesh();
-	auto testModel = Gadget::MeshLoader::LoadMeshFromFile("assets\\teapot.stl");
-	const auto& testMesh = testModel.meshes[0];
+	const auto testModel = RS::LoadCachedModel("assets/teapot.stl");
+	if (testModel.IsEmpty())
+	{
+		std::println("Could not load the teapot model");
+		return 1;
+	}
+	const auto& testMesh = testModel.Meshes()[0];
 
 	auto aspect = screenW * 1.0 / screenH;
 
@@ -217,16 +239,22 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
 		shouldContinue = false;
 	});
 
-	auto resizeDelegateHandle = window->EventHandler().OnWindowResized.Add([&aspect, &frameBuffer, &viewport](int32_t w, int32_t h)
+	auto resizeDelegateHandle = window->EventHandler().OnWindowResized.Add([&aspect, &swapChain, &viewport](int32_t w, int32_t h)
 	{
 		aspect = w * 1.0 / h;
-		frameBuffer = RS::FrameBuffer(w, h);
+		swapChain.Resize(static_cast<uint16_t>(w), static_cast<uint16_t>(h));
 		viewport = RS::Viewport(0, w, 0, h);
 	});
 
 	while (shouldContinue)
 	{
-		window->HandleEvents();
+		RS_PROFILE_BEGIN_FRAME();
+		RS_PROFILE_SCOPE(RS::ProfileStage::Frame);
+
+		{
+			RS_PROFILE_SCOPE(RS::ProfileStage::Events);
+			window->HandleEvents();
+		}
 
 		curTime = std::chrono::system_clock::now().time_since_epoch();
 		counter.AddFrameTime(std::chrono::duration_cast<std::chrono::microseconds>(curTime - prevTime));
@@ -242,20 +270,16 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
 		transform = (positionMatrix * (rotationMatrix * scaleMatrix));
 		transform = Gadget::Matrix4::Perspective(90.0, aspect, 0.01, 1000.0) * transform;
 
+		auto& frameBuffer = swapChain.BeginFrame();
 		frameBuffer.Clear();
-		Draw(viewport, frameBuffer, RS::DrawCall(testMesh, transform));
-
-		auto surfaceView = window->GetSurfaceView();
-		surfaceView.Lock();
-		surfaceView.Clear(Gadget::Color(0.1f, 0.1f, 0.1f));
-		CopyFrameBuffer(surfaceView, frameBuffer);
-		surfaceView.Unlock();
+		renderer.Draw(viewport, frameBuffer, RS::DrawCall(testMesh, transform));
+		swapChain.EndFrame();
 
-		window->UpdateWindowSurface();
 		prevTime = curTime;
 	}
 
 	window.reset();
 	std::println("Average frame time: {:.3f}ms", counter.GetAverageFrameTimeInMicroseconds() / 1'000.0);
+	FinishProfiling(trace);
 	return 0;
 }
@@ -0,0 +1,555 @@
+#include "Renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include <GCore/Assert.hpp>
+
+#include "Culling.hpp"
+#include "Profiler.hpp"
+#include "Raster.hpp"
+#include "RasterKernels.hpp"
+
+using namespace RS;
+
+// Tests every pixel center in the triangle's bounds, and shrinks the bounds to the covered ones
+// Returns false if none are covered
+static bool ShrinkToCoveredPixels(BinnedTriangle& tri)
+{
+	int32_t minX = tri.maxX;
+	int32_t minY = tri.maxY;
+	int32_t maxX = tri.minX;
+	int32_t maxY = tri.minY;
+	for (int32_t y = tri.minY; y < tri.maxY; y++)
+	{
+		for (int32_t x = tri.minX; x < tri.maxX; x++)
+		{
+			if ((tri.edges[0].Evaluate(x, y) | tri.edges[1].Evaluate(x, y) | tri.edges[2].Evaluate(x, y)) >= 0)
+			{
+				minX = std::min(minX, x);
+				minY = std::min(minY, y);
+				maxX = std::max(maxX, x + 1);
+				maxY = std::max(maxY, y + 1);
+			}
+		}
+	}
+
+	if (minX >= maxX)
+	{
+		return false;
+	}
+
+	tri.minX = minX;
+	tri.minY = minY;
+	tri.maxX = maxX;
+	tri.maxY = maxY;
+	return true;
+}
+
+// Projects a clipped triangle to the viewport, culls it and sets up its edge functions
+// Returns false if the triangle does not need to be rasterized
+static bool SetupTriangle(const Raster::Triangle& tri, const Viewport& viewport, const FrameBuffer& frameBuffer, const DrawCall& drawCall, BinnedTriangle& outTri)
+{
+	auto vert0 = tri[0];
+	auto vert1 = tri[1];
+	auto vert2 = tri[2];
+
+	auto projVert0 = vert0.position.Project();
+	auto projVert1 = vert1.position.Project();
+	auto projVert2 = vert2.position.Project();
+
+	auto v0 = viewport.NdcToViewport(projVert0);
+	auto v1 = viewport.NdcToViewport(projVert1);
+	auto v2 = viewport.NdcToViewport(projVert2);
+
+	// Guard band clipping keeps everything well inside the fixed point range, this only catches degenerate (w = 0) input
+	for (const auto& v : { v0, v1, v2 })
+	{
+		if (!(std::abs(v.x) < Raster::MaxFixedPointCoordinate && std::abs(v.y) < Raster::MaxFixedPointCoordinate))
+		{
+			return false;
+		}
+	}
+
+	// Snap to the sub-pixel grid
+	std::array<int64_t, 3> xs = { Raster::ToFixedPoint(v0.x), Raster::ToFixedPoint(v1.x), Raster::ToFixedPoint(v2.x) };
+	std::array<int64_t, 3> ys = { Raster::ToFixedPoint(v0.y), Raster::ToFixedPoint(v1.y), Raster::ToFixedPoint(v2.y) };
+
+	int64_t area = ((xs[1] - xs[0]) * (ys[2] - ys[0])) - ((ys[1] - ys[0]) * (xs[2] - xs[0]));
+	if (area == 0)
+	{
+		return false; // Early out, triangle has no area after snapping
+	}
+
+	const bool ccw = area < 0;
+	if ((ccw && drawCall.mode == CullMode::CW) || (!ccw && drawCall.mode == CullMode::CCW))
+	{
+		return false; // Skip this triangle (back-face culling)
+	}
+
+	if (ccw)
+	{
+		std::swap(vert1, vert2);
+		std::swap(projVert1, projVert2);
+		std::swap(xs[1], xs[2]);
+		std::swap(ys[1], ys[2]);
+		area = -area;
+	}
+
+	// Pixel bounds, clamped to the render target and viewport
+	const auto [minFx, maxFx] = std::minmax({ xs[0], xs[1], xs[2] });
+	const auto [minFy, maxFy] = std::minmax({ ys[0], ys[1], ys[2] });
+
+	outTri.minX = static_cast<int32_t>(std::max<int64_t>(minFx >> Raster::SubPixelBits, std::max(viewport.GetXMin(), 0)));
+	outTri.minY = static_cast<int32_t>(std::max<int64_t>(minFy >> Raster::SubPixelBits, std::max(viewport.GetYMin(), 0)));
+	outTri.maxX = static_cast<int32_t>(std::min<int64_t>((maxFx >> Raster::SubPixelBits) + 1, std::min<int32_t>(viewport.GetXMax(), frameBuffer.Width())));
+	outTri.maxY = static_cast<int32_t>(std::min<int64_t>((maxFy >> Raster::SubPixelBits) + 1, std::min<int32_t>(viewport.GetYMax(), frameBuffer.Height())));
+
+	if (outTri.minX >= outTri.maxX || outTri.minY >= outTri.maxY)
+	{
+		return false; // Early out, triangle bounds are fully off-screen
+	}
+
+	outTri.edges[0] = Raster::SetupEdge(xs[1], ys[1], xs[2], ys[2]);
+	outTri.edges[1] = Raster::SetupEdge(xs[2], ys[2], xs[0], ys[0]);
+	outTri.edges[2] = Raster::SetupEdge(xs[0], ys[0], xs[1], ys[1]);
+
+	// Small triangles only have a few pixel centers to test, and often cover none of them
+	// Testing them here skips the attribute setup for those, and tightens the bounds binning and Hi-Z see for the rest
+	const bool isSmall = outTri.maxX - outTri.minX <= Raster::SmallTriangleSize && outTri.maxY - outTri.minY <= Raster::SmallTriangleSize;
+	if (isSmall && !ShrinkToCoveredPixels(outTri))
+	{
+		return false; // Early out, triangle falls between pixel centers
+	}
+
+	const Real invArea = 1 / static_cast<Real>(area);
+	const auto setupAttribute = [&](Real a0, Real a1, Real a2)
+	{
+		return Raster::SetupAttribute(outTri.edges, invArea, outTri.minX, outTri.minY, a0, a1, a2);
+	};
+
+	outTri.depth = setupAttribute(projVert0.z, projVert1.z, projVert2.z);
+
+	// Colors are interpolated as color / w, and divided by the interpolated 1 / w per pixel
+	// If w is the same at every vertex that's a no-op, so those triangles keep the cheaper linear path
+	const std::array<Real, 3> invW = { 1 / vert0.position.w, 1 / vert1.position.w, 1 / vert2.position.w };
+	outTri.isPerspective = drawCall.perspectiveCorrect && (invW[0] != invW[1] || invW[1] != invW[2]);
+
+	const std::array<Real, 3> colorScale = outTri.isPerspective ? invW : std::array<Real, 3>{ 1, 1, 1 };
+	outTri.color[0] = setupAttribute(vert0.color.r * colorScale[0], vert1.color.r * colorScale[1], vert2.color.r * colorScale[2]);
+	outTri.color[1] = setupAttribute(vert0.color.g * colorScale[0], vert1.color.g * colorScale[1], vert2.color.g * colorScale[2]);
+	outTri.color[2] = setupAttribute(vert0.color.b * colorScale[0], vert1.color.b * colorScale[1], vert2.color.b * colorScale[2]);
+	outTri.color[3] = setupAttribute(vert0.color.a * colorScale[0], vert1.color.a * colorScale[1], vert2.color.a * colorScale[2]);
+	outTri.invW = outTri.isPerspective ? setupAttribute(invW[0], invW[1], invW[2]) : Raster::AttributePlane();
+
+	// Texture coordinates get the same perspective treatment as colors
+	if (drawCall.IsTextured())
+	{
+		outTri.texCoord[0] = setupAttribute(vert0.texCoord.u * colorScale[0], vert1.texCoord.u * colorScale[1], vert2.texCoord.u * colorScale[2]);
+		outTri.texCoord[1] = setupAttribute(vert0.texCoord.v * colorScale[0], vert1.texCoord.v * colorScale[1], vert2.texCoord.v * colorScale[2]);
+	}
+
+	// Depth is planar, so the vertices bound it. The barycentrics include the fill rule bias though,
+	// so they can sum to as little as 1 - 2 / area, which pulls depth towards z = 0
+	const Real shrink = std::max<Real>(0, 1 - (2 * invArea));
+	const auto [minVertexZ, maxVertexZ] = std::minmax({ projVert0.z, projVert1.z, projVert2.z });
+	const Real minZ = std::min(minVertexZ, minVertexZ * shrink);
+	const Real maxZ = std::max(maxVertexZ, maxVertexZ * shrink);
+
+	// Widened some more to absorb rounding in the interpolation
+	const uint32_t minDepth = Raster::QuantizeDepth(minZ);
+	const uint32_t maxDepth = Raster::QuantizeDepth(maxZ);
+	outTri.minDepth = minDepth - std::min(minDepth, Raster::DepthRoundingSlack);
+	outTri.maxDepth = maxDepth + std::min(std::numeric_limits<uint32_t>::max() - maxDepth, Raster::DepthRoundingSlack);
+	return true;
+}
+
+static Gadget::Color Tint(const Gadget::Color& color, const Gadget::Color& tint)
+{
+	return Gadget::Color(color.r * tint.r, color.g * tint.g, color.b * tint.b, color.a * tint.a);
+}
+
+// Tests every instance's bounding box against the frustum, so instances that are completely off-screen never reach the vertex stage
+static void FindVisibleInstances(const DrawCall& drawCall, std::vector<uint32_t>& outVisible)
+{
+	GADGET_BASIC_ASSERT(drawCall.instanceColors.empty() || drawCall.instanceColors.size() == drawCall.instanceTransforms.size());
+
+	const auto& bounds = drawCall.mesh.bounds;
+	std::array<Gadget::Vector4, 8> corners;
+	for (size_t i = 0; i < corners.size(); i++)
+	{
+		corners[i] = Gadget::Vector4((i & 1) ? bounds.max.x : bounds.min.x, (i & 2) ? bounds.max.y : bounds.min.y, (i & 4) ? bounds.max.z : bounds.min.z, 1.0);
+	}
+
+	for (size_t i = 0; i < drawCall.instanceTransforms.size(); i++)
+	{
+		const auto transform = drawCall.transform * drawCall.instanceTransforms[i];
+
+		// Culled only if every corner is outside the same plane
+		uint16_t outside = Raster::FrustumOutcodes;
+		for (const auto& corner : corners)
+		{
+			outside &= Raster::ComputeOutcode(ClipPosition(transform * corner));
+			if (outside == 0)
+			{
+				break;
+			}
+		}
+
+		if (outside == 0)
+		{
+			outVisible.push_back(static_cast<uint32_t>(i));
+		}
+	}
+}
+
+void Renderer::Draw(const Viewport& viewport, FrameBuffer& frameBuffer, const DrawCall& drawCall)
+{
+	immediateCommands.Clear();
+	immediateCommands.Add(drawCall);
+	Submit(viewport, frameBuffer, immediateCommands);
+}
+
+size_t Renderer::BuildRanges(const CommandList& commands)
+{
+	RS_PROFILE_SCOPE(ProfileStage::Setup);
+
+	commands.BuildExecutionOrder(executionOrder);
+
+	// Split every draw into ranges of vertices and triangles. Triangle ranges double as binning producers,
+	// so walking a tile's bins visits draws in execution order and triangles in instance and mesh order
+	if (drawInstances.size() < commands.Size())
+	{
+		drawInstances.resize(commands.Size());
+	}
+
+	vertexRanges.clear();
+	triangleRanges.clear();
+
+	size_t numVertices = 0;
+	for (const auto draw : executionOrder)
+	{
+		const auto& drawCall = commands[draw];
+		auto& instances = drawInstances[draw];
+		instances.visible.clear();
+		if (!drawCall.IsInstanced())
+		{
+			instances.visible.push_back(0);
+		}
+		else if (!drawCall.mesh.vertices.empty())
+		{
+			FindVisibleInstances(drawCall, instances.visible);
+		}
+		instances.kernels = {
+			(*tileKernels)[Raster::PipelineState::FromDraw(drawCall, false).Index()],
+			(*tileKernels)[Raster::PipelineState::FromDraw(drawCall, true).Index()]
+		};
+		instances.sampler = TextureSampler{ drawCall.texture, drawCall.textureFilter };
+		GADGET_BASIC_ASSERT(!drawCall.IsTextured() || drawCall.mesh.texCoords.size() == drawCall.mesh.vertices.size());
+
+		instances.vertexOffset = numVertices;
+		const size_t drawVertices = drawCall.mesh.vertices.size() * instances.visible.size();
+		const size_t drawTriangles = (drawCall.mesh.indices.size() / 3) * instances.visible.size();
+		numVertices += drawVertices;
+
+		if (collectStatistics)
+		{
+			const size_t submittedTriangles = (drawCall.mesh.indices.size() / 3) * drawCall.NumInstances();
+			statistics.inputPrimitives += submittedTriangles;
+			statistics.culledPrimitives += submittedTriangles - drawTriangles;
+		}
+
+		for (size_t begin = 0; begin < drawVertices; begin += VerticesPerJob)
+		{
+			vertexRanges.push_back(DrawRange{ draw, begin, std::min(begin + VerticesPerJob, drawVertices) });
+		}
+
+		if (drawCall.mesh.meshlets.empty())
+		{
+			AddTriangleRange(draw, 0, drawTriangles);
+			continue;
+		}
+
+		// Meshlets that are off-screen or facing away are left out of the ranges, so none of their triangles reach the cull stage
+		const size_t numMeshTriangles = drawCall.mesh.NumTriangles();
+		for (size_t instance = 0; instance < instances.visible.size(); instance++)
+		{
+			const auto transform = drawCall.IsInstanced() ? drawCall.transform * drawCall.instanceTransforms[instances.visible[instance]] : drawCall.transform;
+			const Raster::MeshletCuller culler(transform, drawCall.mode);
+
+			for (const auto& meshlet : drawCall.mesh.meshlets)
+			{
+				if (culler.IsVisible(meshlet))
+				{
+					const size_t begin = (instance * numMeshTriangles) + meshlet.triangleOffset;
+					AddTriangleRange(draw, begin, begin + meshlet.triangleCount);
+				}
+				else if (collectStatistics)
+				{
+					statistics.culledPrimitives += meshlet.triangleCount;
+				}
+			}
+		}
+	}
+
+	return numVertices;
+}
+
+void Renderer::AddTriangleRange(uint32_t draw, size_t begin, size_t end)
+{
+	while (begin < end)
+	{
+		if (!triangleRanges.empty())
+		{
+			auto& last = triangleRanges.back();
+			if (last.draw == draw && last.end == begin && last.end - last.begin < TrianglesPerJob)
+			{
+				const size_t count = std::min(end - begin, TrianglesPerJob - (last.end - last.begin));
+				last.end += count;
+				begin += count;
+				continue;
+			}
+		}
+
+		const size_t count = std::min(end - begin, TrianglesPerJob);
+		triangleRanges.push_back(DrawRange{ draw, begin, begin + count });
+		begin += count;
+	}
+}
+
+void Renderer::Submit(const Viewport& viewport, FrameBuffer& frameBuffer, const CommandList& commands)
+{
+	const size_t numVertices = BuildRanges(commands);
+	const size_t numJobs = triangleRanges.size();
+
+	if (collectStatistics)
+	{
+		threadStatistics.assign(jobSystem.NumThreadSlots(), ThreadStatistics());
+	}
+	binner.Reset(frameBuffer.Width(), frameBuffer.Height(), numJobs);
+
+	// Vertex stage - transform every vertex once, no matter how many triangles share it
+	clipVertices.Resize(numVertices);
+	jobSystem.ParallelFor(vertexRanges.size(), 1, [&](size_t job, size_t /* end */)
+	{
+		RS_PROFILE_SCOPE(ProfileStage::Vertex);
+
+		const auto& range = vertexRanges[job];
+		const auto& drawCall = commands[range.draw];
+		const auto& instances = drawInstances[range.draw];
+		const auto& vertices = drawCall.mesh.vertices;
+
+		// One segment per instance the range overlaps
+		for (size_t segmentBegin = range.begin; segmentBegin < range.end;)
+		{
+			const size_t instance = segmentBegin / vertices.size();
+			const size_t instanceStart = instance * vertices.size();
+			const size_t segmentEnd = std::min(range.end, instanceStart + vertices.size());
+
+			const uint32_t instanceIndex = instances.visible[instance];
+			const auto transform = drawCall.IsInstanced() ? drawCall.transform * drawCall.instanceTransforms[instanceIndex] : drawCall.transform;
+			const bool isTinted = !drawCall.instanceColors.empty();
+			const bool isTextured = drawCall.IsTextured();
+
+			for (size_t i = segmentBegin; i < segmentEnd; i++)
+			{
+				const auto& vertex = vertices[i - instanceStart];
+				// The one place positions are narrowed to the pipeline's precision
+				const auto position = ClipPosition(transform * vertex.position);
+				const auto color = isTinted ? Tint(vertex.color, drawCall.instanceColors[instanceIndex]) : vertex.color;
+				const auto outcode = Raster::ComputeOutcode(position);
+
+				const size_t index = instances.vertexOffset + i;
+				clipVertices.Set(index, position, color, outcode);
+				if (isTextured)
+				{
+					clipVertices.SetTexCoord(index, drawCall.mesh.texCoords[i - instanceStart]);
+				}
+
+				// Snapped once here so the cull stage sees exactly the area triangle setup would
+				if ((outcode & Raster::ClipOutcodes) == 0 && position.w > 0)
+				{
+					const auto screen = viewport.NdcToViewport(position.Project());
+					clipVertices.snappedX[index] = Raster::ToFixedPoint(screen.x);
+					clipVertices.snappedY[index] = Raster::ToFixedPoint(screen.y);
+				}
+			}
+
+			segmentBegin = segmentEnd;
+		}
+	});
+
+	// Cull stage - drop back-facing, degenerate and off-screen triangles in bulk, leaving a compact list per range
+	if (survivors.size() < numJobs)
+	{
+		survivors.resize(numJobs);
+	}
+
+	jobSystem.ParallelFor(numJobs, 1, [&](size_t job, size_t /* end */)
+	{
+		RS_PROFILE_SCOPE(ProfileStage::Cull);
+
+		const auto& range = triangleRanges[job];
+		const auto& drawCall = commands[range.draw];
+		const auto& instances = drawInstances[range.draw];
+		const size_t numMeshVertices = drawCall.mesh.vertices.size();
+		const size_t numMeshTriangles = drawCall.mesh.indices.size() / 3;
+
+		auto& jobSurvivors = survivors[job];
+		jobSurvivors.clear();
+
+		for (size_t segmentBegin = range.begin; segmentBegin < range.end;)
+		{
+			const size_t instance = segmentBegin / numMeshTriangles;
+			const size_t instanceStart = instance * numMeshTriangles;
+			const size_t segmentEnd = std::min(range.end, instanceStart + numMeshTriangles);
+
+			const size_t vertexOffset = instances.vertexOffset + (instance * numMeshVertices);
+			Raster::CullTriangles(clipVertices, drawCall.mesh, vertexOffset, segmentBegin - instanceStart, segmentEnd - instanceStart, drawCall.mode, instanceStart, jobSurvivors);
+
+			segmentBegin = segmentEnd;
+		}
+
+		if (auto* threadStats = GetThreadStatistics(); threadStats != nullptr)
+		{
+			threadStats->culledPrimitives += (range.end - range.begin) - jobSurvivors.size();
+		}
+	});
+
+	// Geometry stage - assemble, clip, set up and bin the survivors
+	jobSystem.ParallelFor(numJobs, 1, [&](size_t job, size_t /* end */)
+	{
+		RS_PROFILE_SCOPE(ProfileStage::Clip);
+
+		const auto& range = triangleRanges[job];
+		const auto& drawCall = commands[range.draw];
+		const auto& instances = drawInstances[range.draw];
+		const auto& indices = drawCall.mesh.indices;
+		const size_t numMeshVertices = drawCall.mesh.vertices.size();
+		const size_t numMeshTriangles = indices.size() / 3;
+
+		BinnedTriangle binnedTri;
+		binnedTri.draw = range.draw;
+
+		PipelineStatistics jobStats;
+
+		for (const auto survivor : survivors[job])
+		{
+			const size_t instance = survivor / numMeshTriangles;
+			const size_t t = survivor - (instance * numMeshTriangles);
+			const size_t offset = instances.vertexOffset + (instance * numMeshVertices);
+
+			const size_t i0 = offset + indices[(t * 3)];
+			const size_t i1 = offset + indices[(t * 3) + 1];
+			const size_t i2 = offset + indices[(t * 3) + 2];
+
+			const auto outcode0 = clipVertices.outcodes[i0];
+			const auto outcode1 = clipVertices.outcodes[i1];
+			const auto outcode2 = clipVertices.outcodes[i2];
+
+			const Raster::Triangle tri = { clipVertices.GetVertex(i0), clipVertices.GetVertex(i1), clipVertices.GetVertex(i2) };
+			if (Raster::IsTriviallyAccepted(outcode0, outcode1, outcode2))
+			{
+				if (SetupTriangle(tri, viewport, frameBuffer, drawCall, binnedTri))
+				{
+					binner.Add(job, binnedTri);
+					jobStats.binnedPrimitives++;
+				}
+				else
+				{
+					jobStats.setupRejectedPrimitives++;
+				}
+				continue;
+			}
+
+			const auto clippedTris = Raster::ClipTriangle(tri, outcode0 | outcode1 | outcode2);
+			jobStats.clippedPrimitives++;
+			jobStats.clipOutputPrimitives += clippedTris.size();
+
+			for (const auto& clippedTri : clippedTris)
+			{
+				if (SetupTriangle(clippedTri, viewport, frameBuffer, drawCall, binnedTri))
+				{
+					binner.Add(job, binnedTri);
+					jobStats.binnedPrimitives++;
+				}
+				else
+				{
+					jobStats.setupRejectedPrimitives++;
+				}
+			}
+		}
+
+		if (auto* threadStats = GetThreadStatistics(); threadStats != nullptr)
+		{
+			*threadStats += jobStats;
+		}
+	});
+
+	binner.Finish();
+
+	// Raster stage - each tile is owned by exactly one job
+	jobSystem.ParallelFor(binner.NumTiles(), 1, [&](size_t tile, size_t /* end */)
+	{
+		RS_PROFILE_SCOPE(ProfileStage::Raster);
+
+		const auto tileRect = binner.GetTileRect(tile);
+		auto* threadStats = GetThreadStatistics();
+
+		binner.ForEachTriangle(tile, [&](const BinnedTriangle& tri)
+		{
+			const auto& drawCall = commands[tri.draw];
+
+			// Large triangles leave much of their bounds empty, so find the blocks they actually touch first
+			Raster::BlockCoverage coverage{ ~uint64_t{ 0 }, 0 };
+			if (Raster::IsLargeTriangle(tri))
+			{
+				coverage = Raster::ClassifyCoverage(tri, tileRect);
+				if (coverage.overlapped == 0)
+				{
+					if (threadStats != nullptr)
+					{
+						threadStats->edgeRejectedTiles++;
+					}
+					return; // Only the triangle's bounds overlap this tile
+				}
+			}
+
+			auto blocks = frameBuffer.hiZ.Classify(tileRect, tri, drawCall.depthMode, frameBuffer.depth, coverage.overlapped);
+			blocks.covered = coverage.covered & blocks.visible;
+			if (blocks.visible == 0)
+			{
+				if (threadStats != nullptr)
+				{
+					threadStats->hiZRejectedTiles++;
+				}
+				return; // Hidden behind what's already in the depth buffer
+			}
+
+			if (threadStats != nullptr)
+			{
+				threadStats->edgeAcceptedBlocks += std::popcount(blocks.covered);
+			}
+
+			frameBuffer.ResolveTile(tileRect);
+			const auto& instances = drawInstances[tri.draw];
+			instances.kernels[tri.isPerspective ? 1 : 0](tri, tileRect, blocks, frameBuffer, instances.sampler, threadStats);
+
+			if (drawCall.writeDepth)
+			{
+				frameBuffer.hiZ.Update(tileRect, blocks, tri, drawCall.depthMode);
+			}
+		});
+	});
+
+	if (collectStatistics)
+	{
+		for (const auto& threadStats : threadStatistics)
+		{
+			statistics += threadStats.value;
+		}
+	}
+}
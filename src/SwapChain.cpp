@@ -0,0 +1,125 @@
+#include "SwapChain.hpp"
+
+#include <algorithm>
+
+#include <SDL3/SDL.h>
+
+#include "Present.hpp"
+#include "Profiler.hpp"
+
+using namespace RS;
+
+SwapChain::SwapChain(SDL_Window* window_, JobSystem& jobSystem_, uint16_t width, uint16_t height, PresentMode mode_, size_t bufferCount) : window(window_), jobSystem(jobSystem_), mode(mode_)
+{
+	bufferCount = (mode == PresentMode::Pipelined) ? std::max<size_t>(bufferCount, 2) : 1;
+	buffers.reserve(bufferCount);
+	for (size_t i = 0; i < bufferCount; i++)
+	{
+		buffers.emplace_back(width, height);
+	}
+
+	presentJob = [this]()
+	{
+		CopyToSurface(presentSurface, *presentSource, backgroundColor);
+	};
+}
+
+SwapChain::~SwapChain()
+{
+	jobSystem.Wait(presentCounter);
+}
+
+void SwapChain::Resize(uint16_t width, uint16_t height)
+{
+	jobSystem.Wait(presentCounter);
+
+	for (auto& buffer : buffers)
+	{
+		buffer = FrameBuffer(width, height);
+	}
+
+	// Whatever was waiting to be presented is the wrong size now
+	hasPendingFrame = false;
+}
+
+// Tiled targets can't live in the surface's memory, CanRenderToSurface never lets them get as far as these
+template <typename Target>
+static void AttachSurface(Target& target, SDL_Surface* surface)
+{
+	if constexpr (Target::IsLinear)
+	{
+		target.Attach(static_cast<typename Target::PixelT*>(surface->pixels), static_cast<uint32_t>(surface->pitch) / sizeof(typename Target::PixelT));
+	}
+}
+
+template <typename Target>
+static void DetachSurface(Target& target)
+{
+	if constexpr (Target::IsLinear)
+	{
+		target.Detach();
+	}
+}
+
+FrameBuffer& SwapChain::BeginFrame()
+{
+	auto& frameBuffer = buffers[currentBuffer];
+
+	if (mode == PresentMode::Direct)
+	{
+		SDL_Surface* surface = SDL_GetWindowSurface(window);
+		if (CanRenderToSurface(surface, frameBuffer) && SDL_LockSurface(surface))
+		{
+			lockedSurface = surface;
+			AttachSurface(frameBuffer.color, surface);
+		}
+	}
+	else if (mode == PresentMode::Pipelined && hasPendingFrame)
+	{
+		// The window surface has to be retrieved on the main thread, copying into it doesn't
+		presentSurface = SDL_GetWindowSurface(window);
+		if (presentSurface != nullptr)
+		{
+			presentSource = &buffers[(currentBuffer + buffers.size() - 1) % buffers.size()];
+			jobSystem.Run(presentJob, presentCounter);
+		}
+	}
+
+	return frameBuffer;
+}
+
+void SwapChain::EndFrame()
+{
+	RS_PROFILE_SCOPE(ProfileStage::Present);
+
+	auto& frameBuffer = buffers[currentBuffer];
+
+	// Tiles nothing was drawn to still hold last frame's pixels
+	frameBuffer.ResolveColor();
+
+	switch (mode)
+	{
+		case PresentMode::Direct:
+			if (lockedSurface != nullptr)
+			{
+				DetachSurface(frameBuffer.color);
+				SDL_UnlockSurface(lockedSurface);
+				lockedSurface = nullptr;
+				break;
+			}
+
+			Present(window, frameBuffer, backgroundColor);
+			break;
+		case PresentMode::Copy:
+			Present(window, frameBuffer, backgroundColor);
+			break;
+		case PresentMode::Pipelined:
+			// Shows the frame that was copied while this one was rendering, this one goes out next frame
+			jobSystem.Wait(presentCounter);
+			hasPendingFrame = true;
+			currentBuffer = (currentBuffer + 1) % buffers.size();
+			break;
+	}
+
+	SDL_UpdateWindowSurface(window);
+}
@@ -0,0 +1,130 @@
+#include "Texture.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include <GCore/Assert.hpp>
+
+using namespace RS;
+
+static int32_t Wrap(int32_t value, int32_t size)
+{
+	const int32_t result = value % size;
+	return result < 0 ? result + size : result;
+}
+
+static Gadget::Color Lerp(const Gadget::Color& a, const Gadget::Color& b, float t)
+{
+	return Gadget::Color(a.r + ((b.r - a.r) * t), a.g + ((b.g - a.g) * t), a.b + ((b.b - a.b) * t), a.a + ((b.a - a.a) * t));
+}
+
+// Rounded average of a 2x2 footprint
+static PixelRGBA8 Average(const PixelRGBA8& a, const PixelRGBA8& b, const PixelRGBA8& c, const PixelRGBA8& d)
+{
+	const auto average = [](uint8_t p0, uint8_t p1, uint8_t p2, uint8_t p3){ return static_cast<uint8_t>((p0 + p1 + p2 + p3 + 2) / 4); };
+	return PixelRGBA8{ average(a.r, b.r, c.r, d.r), average(a.g, b.g, c.g, d.g), average(a.b, b.b, c.b, d.b), average(a.a, b.a, c.a, d.a) };
+}
+
+Texture::Texture(uint16_t width_, uint16_t height_, std::span<const TexelT> texels)
+{
+	GADGET_BASIC_ASSERT(width_ > 0 && height_ > 0);
+	GADGET_BASIC_ASSERT(texels.size() >= static_cast<size_t>(width_) * height_);
+
+	mips.reserve(static_cast<size_t>(std::bit_width(std::max(width_, height_))));
+
+	MipT base(width_, height_, TexelT{});
+	for (uint16_t y = 0; y < height_; y++)
+	{
+		for (uint16_t x = 0; x < width_; x++)
+		{
+			base.SetPixel(x, y, texels[(static_cast<size_t>(y) * width_) + x]);
+		}
+	}
+	mips.push_back(std::move(base));
+
+	while (mips.back().Width() > 1 || mips.back().Height() > 1)
+	{
+		const auto& source = mips.back();
+		const auto sourceWidth = source.Width();
+		const auto sourceHeight = source.Height();
+
+		// Odd sizes drop their last row or column into the texels next to it
+		MipT mip(std::max<uint16_t>(sourceWidth / 2, 1), std::max<uint16_t>(sourceHeight / 2, 1), TexelT{});
+		for (uint16_t y = 0; y < mip.Height(); y++)
+		{
+			const auto y0 = static_cast<uint16_t>(std::min(y * 2, sourceHeight - 1));
+			const auto y1 = static_cast<uint16_t>(std::min((y * 2) + 1, sourceHeight - 1));
+			for (uint16_t x = 0; x < mip.Width(); x++)
+			{
+				const auto x0 = static_cast<uint16_t>(std::min(x * 2, sourceWidth - 1));
+				const auto x1 = static_cast<uint16_t>(std::min((x * 2) + 1, sourceWidth - 1));
+				mip.SetPixel(x, y, Average(source.GetPixel(x0, y0), source.GetPixel(x1, y0), source.GetPixel(x0, y1), source.GetPixel(x1, y1)));
+			}
+		}
+
+		mips.push_back(std::move(mip));
+	}
+}
+
+Gadget::Color Texture::Sample(float u, float v, float lod, TextureFilter filter) const
+{
+	// Also catches NaN, i.e. from a triangle that's edge-on
+	const auto maxLevel = static_cast<float>(mips.size() - 1);
+	lod = lod > 0.0f ? std::min(lod, maxLevel) : 0.0f;
+
+	switch (filter)
+	{
+		case TextureFilter::Nearest:
+			return SampleNearest(static_cast<size_t>(lod + 0.5f), u, v);
+		case TextureFilter::Bilinear:
+			return SampleBilinear(static_cast<size_t>(lod + 0.5f), u, v);
+		case TextureFilter::Trilinear:
+			break;
+	}
+
+	const auto level = static_cast<size_t>(lod);
+	const float t = lod - static_cast<float>(level);
+	if (level + 1 >= mips.size() || t == 0.0f)
+	{
+		return SampleBilinear(level, u, v);
+	}
+
+	return Lerp(SampleBilinear(level, u, v), SampleBilinear(level + 1, u, v), t);
+}
+
+Gadget::Color Texture::SampleNearest(size_t level, float u, float v) const
+{
+	const auto& mip = mips[level];
+
+	// Wrapped before scaling, so coordinates far outside [0, 1] can't overflow
+	const float fu = u - std::floor(u);
+	const float fv = v - std::floor(v);
+	const auto x = static_cast<uint16_t>(std::min(static_cast<int32_t>(fu * mip.Width()), mip.Width() - 1));
+	const auto y = static_cast<uint16_t>(std::min(static_cast<int32_t>(fv * mip.Height()), mip.Height() - 1));
+	return UnpackColor(mip.GetPixel(x, y));
+}
+
+Gadget::Color Texture::SampleBilinear(size_t level, float u, float v) const
+{
+	const auto& mip = mips[level];
+	const int32_t width = mip.Width();
+	const int32_t height = mip.Height();
+
+	// Texel centers are at half coordinates
+	const float fx = ((u - std::floor(u)) * static_cast<float>(width)) - 0.5f;
+	const float fy = ((v - std::floor(v)) * static_cast<float>(height)) - 0.5f;
+	const float floorX = std::floor(fx);
+	const float floorY = std::floor(fy);
+	const float tx = fx - floorX;
+	const float ty = fy - floorY;
+
+	const auto x0 = static_cast<uint16_t>(Wrap(static_cast<int32_t>(floorX), width));
+	const auto y0 = static_cast<uint16_t>(Wrap(static_cast<int32_t>(floorY), height));
+	const auto x1 = static_cast<uint16_t>(Wrap(x0 + 1, width));
+	const auto y1 = static_cast<uint16_t>(Wrap(y0 + 1, height));
+
+	const auto top = Lerp(UnpackColor(mip.GetPixel(x0, y0)), UnpackColor(mip.GetPixel(x1, y0)), tx);
+	const auto bottom = Lerp(UnpackColor(mip.GetPixel(x0, y1)), UnpackColor(mip.GetPixel(x1, y1)), tx);
+	return Lerp(top, bottom, ty);
+}